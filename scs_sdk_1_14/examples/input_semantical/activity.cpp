@@ -0,0 +1,68 @@
+#include <stdio.h>
+
+#include "activity.h"
+#include "log.h"
+#include "platform.h"
+
+static activity_t* published = NULL;
+static shared_event_t activityEvent;
+
+// The device starts inactive, the game counts as running until the telemetry
+// says otherwise so that the plugin works without the telemetry part.
+static bool deviceActive = false;
+static bool gameRunning = true;
+
+static void publish(void)
+{
+	if (!published) {
+		return;
+	}
+	const scs_u32_t state = (deviceActive ? activity_device_active : 0) | (gameRunning ? activity_game_running : 0);
+	if (published->state.load(std::memory_order_relaxed) == state) {
+		return;
+	}
+	published->state.store(state, std::memory_order_release);
+	published->changes.fetch_add(1, std::memory_order_release);
+	shared_event_signal(activityEvent, published->changes);
+}
+
+bool activity_open(activity_t& block, const char* const name)
+{
+	char event_name[256];
+	snprintf(event_name, sizeof(event_name), "%s%s", name, activityEventSuffix);
+	if (!shared_event_create(activityEvent, event_name)) {
+		log_line("Failed to create event %s.", event_name);
+		return false;
+	}
+
+	published = &block;
+	published->state.store(0, std::memory_order_relaxed);
+	publish();
+	return true;
+}
+
+void activity_close(void)
+{
+	published = NULL;
+	shared_event_close(activityEvent);
+}
+
+void activity_set_device_active(const bool active)
+{
+	if (active != deviceActive) {
+		log_line(active ? "Device activated." : "Device deactivated.");
+	}
+	deviceActive = active;
+	publish();
+}
+
+void activity_set_game_running(const bool running)
+{
+	gameRunning = running;
+	publish();
+}
+
+bool activity_busy(void)
+{
+	return deviceActive && gameRunning;
+}
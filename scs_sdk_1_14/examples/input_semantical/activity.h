@@ -0,0 +1,17 @@
+#ifndef INPUT_SEMANTICAL_ACTIVITY_H
+#define INPUT_SEMANTICAL_ACTIVITY_H
+
+#include "control_layout.h"
+
+// Starts publishing into the block and creates the accompanying event.
+bool activity_open(activity_t& published, const char* const name);
+void activity_close(void);
+
+// Called from the input and telemetry callbacks on the game thread.
+void activity_set_device_active(const bool active);
+void activity_set_game_running(const bool running);
+
+// True when the device is polled and the simulation runs.
+bool activity_busy(void);
+
+#endif // INPUT_SEMANTICAL_ACTIVITY_H
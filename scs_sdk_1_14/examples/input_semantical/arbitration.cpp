@@ -0,0 +1,146 @@
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+#include <string.h>
+
+#include "arbitration.h"
+#include "input_group.h"
+
+// Number of attempts to get a consistent copy of a producer slot before
+// falling back to the previous one.
+const int arbitrationReadAttempts = 3;
+
+// What the plugin remembers about every producer slot.
+struct producer_memory_t
+{
+	scs_u32_t id;
+	scs_u32_t heartbeat;
+	scs_u64_t heartbeat_time;
+	bool valid;			// values holds a consistent copy
+	scs_u32_t priority;
+	scs_u64_t ownership;
+	float values[inputCount];	// numbered like the slots
+};
+
+static producer_memory_t memory[producerSlotCount];
+
+static int lowest_bit(const scs_u64_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(mask);
+#endif
+}
+
+static bool copy_slot(const producer_slot_t& slot, producer_memory_t& copy)
+{
+	for (int attempt = 0; attempt < arbitrationReadAttempts; attempt++)
+	{
+		const scs_u32_t before = slot.sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;
+		}
+
+		const scs_u32_t priority = slot.priority;
+		const scs_u64_t ownership = slot.ownership;
+		float values[inputCount];
+		for (int i = 0; i < axisCount; i++)
+		{
+			values[i] = slot.axes[i];
+		}
+		for (int i = 0; i < buttonCount; i++)
+		{
+			values[axisCount + i] = slot.buttons[i] ? 1.0f : 0.0f;
+		}
+		scs_u8_t groups[input_group_count];
+		memcpy(groups, slot.groups, sizeof(groups));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == before) {
+			input_group_expand(groups, values);
+			copy.priority = priority;
+			copy.ownership = ownership;
+			memcpy(copy.values, values, sizeof(values));
+			copy.valid = true;
+			return true;
+		}
+	}
+
+	// Keep the previous copy.
+	return false;
+}
+
+int arbitration_merge(producer_slot_t* const producers, const scs_u64_t time, const scs_u64_t timeout, float* const slots)
+{
+	int torn = 0;
+	// Live producers ordered by descending priority.
+	int order[producerSlotCount];
+	int liveCount = 0;
+
+	for (int i = 0; i < producerSlotCount; i++)
+	{
+		producer_slot_t& slot = producers[i];
+		producer_memory_t& copy = memory[i];
+
+		const scs_u32_t id = slot.id.load(std::memory_order_acquire);
+		const scs_u32_t heartbeat = slot.heartbeat.load(std::memory_order_relaxed);
+		if (id != copy.id) {
+			// A new producer in the slot has to beat once before it counts.
+			memset(&copy, 0, sizeof(copy));
+			copy.id = id;
+			copy.heartbeat = heartbeat;
+		}
+		else if (heartbeat != copy.heartbeat) {
+			copy.heartbeat = heartbeat;
+			copy.heartbeat_time = time;
+		}
+
+		const bool live = id != 0 && copy.heartbeat_time != 0 && time - copy.heartbeat_time <= timeout;
+		slot.live.store(live ? 1 : 0, std::memory_order_relaxed);
+		slot.granted = 0;
+		if (!live) {
+			continue;
+		}
+
+		if (!copy_slot(slot, copy)) {
+			torn++;
+		}
+		if (!copy.valid) {
+			continue;
+		}
+
+		int position = liveCount++;
+		while (position > 0 && memory[order[position - 1]].priority < copy.priority)
+		{
+			order[position] = order[position - 1];
+			position--;
+		}
+		order[position] = i;
+	}
+
+	const scs_u64_t all = (inputCount == 64) ? ~0ull : ((1ull << inputCount) - 1);
+	scs_u64_t remaining = all;
+	for (int k = 0; k < liveCount && remaining != 0; k++)
+	{
+		const producer_memory_t& copy = memory[order[k]];
+		const scs_u64_t taken = copy.ownership & remaining;
+		remaining &= ~taken;
+		producers[order[k]].granted = taken;
+
+		for (scs_u64_t bits = taken; bits != 0; bits &= bits - 1)
+		{
+			const int input = lowest_bit(bits);
+			slots[input] = copy.values[input];
+		}
+	}
+	return torn;
+}
+
+void arbitration_reset(void)
+{
+	memset(memory, 0, sizeof(memory));
+}
@@ -0,0 +1,20 @@
+#ifndef INPUT_SEMANTICAL_ARBITRATION_H
+#define INPUT_SEMANTICAL_ARBITRATION_H
+
+#include "control_layout.h"
+
+/**
+ * @brief Merges the producer slots into the input slots.
+ *
+ * For every input owned by a live producer the value of the producer with
+ * the highest priority replaces the slot, ties go to the lower slot index.
+ * Publishes the liveness and the granted inputs of every producer. Returns
+ * the number of slots which kept changing while being copied, for those the
+ * previous copy is used.
+ */
+int arbitration_merge(producer_slot_t* const producers, const scs_u64_t time, const scs_u64_t timeout, float* const slots);
+
+// Forgets the producer history, e.g. when the control block is recreated.
+void arbitration_reset(void);
+
+#endif // INPUT_SEMANTICAL_ARBITRATION_H
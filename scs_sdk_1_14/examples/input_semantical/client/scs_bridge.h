@@ -0,0 +1,49 @@
+/**
+ * @brief Datagram format of tools/scsbridge.
+ *
+ * Producers which can not map the control block, e.g. inside a container,
+ * send one datagram per frame over a Unix domain socket or loopback UDP.
+ * The bridge claims a producer slot per producer id and applies the frames
+ * like scs_client_commit would. Datagrams are little endian, exactly
+ * sizeof(scs_bridge_frame_t) bytes, "<3I4B3Q4f3B5x" in Python struct
+ * notation.
+ */
+#ifndef INPUT_SEMANTICAL_SCS_BRIDGE_H
+#define INPUT_SEMANTICAL_SCS_BRIDGE_H
+
+#include "../control_layout.h"
+
+const scs_u32_t scsBridgeMagic = 0x42534353;	// "SCSB"
+const unsigned short scsBridgeDefaultPort = 47800;
+const char* const scsBridgeDefaultSocket = "/tmp/scsbridge.sock";
+
+enum scs_bridge_flag_t
+{
+	scs_bridge_flag_close = 1		// release the inputs and the slot after this frame
+};
+
+#pragma pack(push, 1)
+
+struct scs_bridge_frame_t
+{
+	scs_u32_t magic;			// scsBridgeMagic
+	scs_u32_t producer;			// nonzero id, see scs_client_open
+	scs_u32_t sequence;			// incremented per frame, older frames are dropped
+	scs_u8_t priority;
+	scs_u8_t flags;				// scs_bridge_flag_t
+	scs_u8_t axis_mask;			// bit i: set axes[i]
+	scs_u8_t group_mask;			// bit i: set groups[i]
+	scs_u64_t button_mask;			// buttons to set, numbered from pause
+	scs_u64_t pressed;			// their values
+	scs_u64_t release;			// inputs to stop controlling, numbered like the inputs
+	float axes[4];
+	scs_u8_t groups[3];
+	scs_u8_t _reserved[5];
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(scs_bridge_frame_t) == 64, "bridge format changed");
+static_assert(axisCount == 4 && input_group_count == 3 && inputCount <= 64, "bridge format out of date");
+
+#endif // INPUT_SEMANTICAL_SCS_BRIDGE_H
@@ -0,0 +1,447 @@
+/**
+ * @brief Header-only C++17 client for producers.
+ *
+ * Maps the control block of a running plugin, checks that it was built
+ * with the same layout and claims one of the producer slots. Values are
+ * stored straight into the slot between scs_client_begin and
+ * scs_client_commit, which make the slot sequence odd and even again, so a
+ * frame costs a handful of stores and no serialization:
+ *
+ *	scs_client_t client;
+ *	if (scs_client_open(client, memname, 1, 10) != scs_client_ok) ...
+ *	while (scs_client_wait_frame(client, 100000))
+ *	{
+ *		scs_client_begin(client);
+ *		scs_client_set_axis(client, axis_steering, steering);
+ *		scs_client_set_button(client, button_lblinker, blink);
+ *		scs_client_commit(client);
+ *	}
+ *	scs_client_close(client);
+ *
+ * The client is not thread safe, use one per thread or lock around it.
+ */
+#ifndef INPUT_SEMANTICAL_SCS_CLIENT_H
+#define INPUT_SEMANTICAL_SCS_CLIENT_H
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <time.h>
+#  include <unistd.h>
+#  ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+#include "../control_layout.h"
+
+enum scs_client_status_t
+{
+	scs_client_ok,
+	scs_client_not_found,		// no plugin created the block yet
+	scs_client_bad_layout,		// plugin built with another layout
+	scs_client_no_slot,		// all producer slots are taken
+	scs_client_full,		// the macro queue is full
+	scs_client_invalid		// bad argument
+};
+
+struct scs_client_t
+{
+	control_block_t* block = nullptr;
+	producer_slot_t* slot = nullptr;
+	scs_u32_t id = 0;
+	scs_u32_t frame = 0;		// last frame returned by scs_client_wait_frame
+	bool writing = false;		// between begin and commit
+#ifdef _WIN32
+	HANDLE mapping = NULL;
+	HANDLE frame_event = NULL;
+	HANDLE ack_event = NULL;
+#else
+	size_t size = 0;
+#endif
+};
+
+inline bool scs_client_map(scs_client_t& client, const char* const name)
+{
+#ifdef _WIN32
+	client.mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+	if (client.mapping == NULL) {
+		return false;
+	}
+	void* const data = MapViewOfFile(client.mapping, FILE_MAP_ALL_ACCESS, 0, 0, memsize);
+	if (data == NULL) {
+		CloseHandle(client.mapping);
+		client.mapping = NULL;
+		return false;
+	}
+	char event_name[256];
+	snprintf(event_name, sizeof(event_name), "%s%s", name, frameEventSuffix);
+	client.frame_event = OpenEventA(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, event_name);
+	if (client.frame_event == NULL) {
+		// scs_client_wait_frame would return at once and spin without it.
+		UnmapViewOfFile(data);
+		CloseHandle(client.mapping);
+		client.mapping = NULL;
+		return false;
+	}
+	snprintf(event_name, sizeof(event_name), "%s%s", name, ackEventSuffix);
+	client.ack_event = OpenEventA(EVENT_MODIFY_STATE, FALSE, event_name);
+#else
+	// Same naming as the plugin, "Local\Name" becomes "/Name".
+	const char prefix[] = "Local\\";
+	const char* base = name;
+	if (strncmp(name, prefix, sizeof(prefix) - 1) == 0) {
+		base += sizeof(prefix) - 1;
+	}
+	char path[256];
+	snprintf(path, sizeof(path), "/%s", base);
+
+	const int fd = shm_open(path, O_RDWR, 0666);
+	if (fd < 0) {
+		return false;
+	}
+	// Mapping past the end of a smaller block from an older plugin would fault.
+	struct stat info;
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < memsize) {
+		close(fd);
+		return false;
+	}
+	void* const data = mmap(NULL, memsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	client.size = memsize;
+#endif
+	client.block = static_cast<control_block_t*>(data);
+	return true;
+}
+
+inline void scs_client_unmap(scs_client_t& client)
+{
+#ifdef _WIN32
+	if (client.block) {
+		UnmapViewOfFile(client.block);
+	}
+	if (client.mapping) {
+		CloseHandle(client.mapping);
+	}
+	if (client.frame_event) {
+		CloseHandle(client.frame_event);
+	}
+	if (client.ack_event) {
+		CloseHandle(client.ack_event);
+	}
+	client.mapping = NULL;
+	client.frame_event = NULL;
+	client.ack_event = NULL;
+#else
+	if (client.block) {
+		munmap(client.block, client.size);
+	}
+	client.size = 0;
+#endif
+	client.block = nullptr;
+	client.slot = nullptr;
+}
+
+// Checks the layout information written by the plugin against this header.
+inline bool scs_client_layout_matches(const control_block_t& block)
+{
+	const layout_info_t& layout = block.layout;
+	return layout.magic.load(std::memory_order_acquire) == layoutMagic && layout.version == layoutVersion && layout.size == memsize && layout.schema == layout_schema();
+}
+
+/**
+ * @brief Maps the block without claiming a producer slot, e.g. for monitoring.
+ *
+ * Only scs_client_wait_frame, scs_client_read_telemetry, the submissions and
+ * direct reads of client.block may be used afterwards.
+ */
+inline scs_client_status_t scs_client_attach(scs_client_t& client, const char* const name)
+{
+	if (!scs_client_map(client, name)) {
+		return scs_client_not_found;
+	}
+	if (!scs_client_layout_matches(*client.block)) {
+		scs_client_unmap(client);
+		return scs_client_bad_layout;
+	}
+	client.frame = client.block->sync.frame.load(std::memory_order_acquire);
+	client.writing = false;
+	return scs_client_ok;
+}
+
+/**
+ * @brief Maps the block and claims a producer slot with the given nonzero id.
+ *
+ * A slot still holding the same id, e.g. left by a previous run of the same
+ * producer, is taken over.
+ */
+inline scs_client_status_t scs_client_open(scs_client_t& client, const char* const name, const scs_u32_t id, const scs_u32_t priority)
+{
+	if (id == 0) {
+		return scs_client_invalid;
+	}
+	const scs_client_status_t attached = scs_client_attach(client, name);
+	if (attached != scs_client_ok) {
+		return attached;
+	}
+
+	for (int i = 0; i < producerSlotCount && !client.slot; i++)
+	{
+		producer_slot_t& slot = client.block->producers[i];
+		scs_u32_t owner = slot.id.load(std::memory_order_relaxed);
+		if (owner == id || (owner == 0 && slot.id.compare_exchange_strong(owner, id, std::memory_order_acq_rel))) {
+			client.slot = &slot;
+		}
+	}
+	if (!client.slot) {
+		scs_client_unmap(client);
+		return scs_client_no_slot;
+	}
+
+	producer_slot_t& slot = *client.slot;
+	const scs_u32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence | 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.priority = priority;
+	slot.ownership = 0;
+	slot.sequence.store((sequence | 1) + 1, std::memory_order_release);
+
+	client.id = id;
+	return scs_client_ok;
+}
+
+// Starts writing the slot, the plugin keeps using the previous commit meanwhile.
+inline void scs_client_begin(scs_client_t& client)
+{
+	if (client.writing) {
+		return;
+	}
+	const scs_u32_t sequence = client.slot->sequence.load(std::memory_order_relaxed);
+	client.slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	client.writing = true;
+}
+
+// Input number of a button, as used by the macros and the ownership masks.
+constexpr scs_u8_t scs_client_button_input(const button_t button)
+{
+	return static_cast<scs_u8_t>(axisCount + button);
+}
+
+// Setters, only valid between begin and commit. Setting an input also takes ownership of it.
+inline void scs_client_set_axis(scs_client_t& client, const axis_t axis, const float value)
+{
+	client.slot->axes[axis] = value;
+	client.slot->ownership |= scs_u64_t(1) << axis;
+}
+
+inline void scs_client_set_button(scs_client_t& client, const button_t button, const bool pressed)
+{
+	client.slot->buttons[button] = pressed;
+	client.slot->ownership |= scs_u64_t(1) << scs_client_button_input(button);
+}
+
+// Buttons with their bit set in mask take the value of the bit in pressed.
+inline void scs_client_set_buttons(scs_client_t& client, const scs_u64_t mask, const scs_u64_t pressed)
+{
+	for (int i = 0; i < buttonCount; i++)
+	{
+		if (mask & (scs_u64_t(1) << i)) {
+			client.slot->buttons[i] = ((pressed >> i) & 1) != 0;
+		}
+	}
+	client.slot->ownership |= (mask & ((scs_u64_t(1) << buttonCount) - 1)) << axisCount;
+}
+
+// Presses only member n - 1 of the group, 0 hands the members back to the individual buttons.
+inline void scs_client_set_group(scs_client_t& client, const input_group_t group, const scs_u8_t member)
+{
+	const input_group_range_t& range = inputGroupRanges[group];
+	client.slot->groups[group] = member;
+	client.slot->ownership |= ((scs_u64_t(1) << range.count) - 1) << range.first;
+}
+
+// Stops controlling the inputs with their bit (numbered like the inputs) set.
+inline void scs_client_release(scs_client_t& client, const scs_u64_t inputs)
+{
+	client.slot->ownership &= ~inputs;
+}
+
+/**
+ * @brief Publishes the values written since begin.
+ *
+ * Also counts as heartbeat for the slot and the fail-safe and acknowledges
+ * the last waited frame for lockstep mode.
+ */
+inline void scs_client_commit(scs_client_t& client)
+{
+	if (!client.writing) {
+		return;
+	}
+	client.slot->sequence.fetch_add(1, std::memory_order_release);
+	client.writing = false;
+
+	client.slot->heartbeat.fetch_add(1, std::memory_order_relaxed);
+	client.block->heartbeat.fetch_add(1, std::memory_order_relaxed);
+	client.block->sync.ack_frame.store(client.frame, std::memory_order_release);
+#if defined(_WIN32)
+	if (client.ack_event) {
+		SetEvent(client.ack_event);
+	}
+#elif defined(__linux__)
+	syscall(SYS_futex, reinterpret_cast<scs_u32_t*>(&client.block->sync.ack_frame), FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+}
+
+// Inputs the slot won in the last frame.
+inline scs_u64_t scs_client_granted(const scs_client_t& client)
+{
+	return client.slot->granted;
+}
+
+/**
+ * @brief Waits for the next frame start, at most timeout microseconds.
+ *
+ * Returns the frame number or 0 on timeout. Frames started since the
+ * previous call are not waited for.
+ */
+inline scs_u32_t scs_client_wait_frame(scs_client_t& client, const scs_u64_t timeout)
+{
+	const std::atomic<scs_u32_t>& counter = client.block->sync.frame;
+	scs_u32_t frame = counter.load(std::memory_order_acquire);
+	if (frame == client.frame) {
+#if defined(_WIN32)
+		// Manual-reset event shared by all producers, see shared_event_t.
+		const DWORD milliseconds = static_cast<DWORD>((timeout + 999) / 1000);
+		if (WaitForSingleObject(client.frame_event, milliseconds) == WAIT_OBJECT_0 && counter.load(std::memory_order_acquire) == frame) {
+			ResetEvent(client.frame_event);
+			if (counter.load(std::memory_order_acquire) == frame) {
+				WaitForSingleObject(client.frame_event, milliseconds);
+			}
+		}
+#elif defined(__linux__)
+		struct timespec relative;
+		relative.tv_sec = static_cast<time_t>(timeout / 1000000);
+		relative.tv_nsec = static_cast<long>(timeout % 1000000) * 1000;
+		syscall(SYS_futex, reinterpret_cast<const scs_u32_t*>(&counter), FUTEX_WAIT, frame, &relative, NULL, 0);
+#else
+		for (scs_u64_t waited = 0; waited < timeout && counter.load(std::memory_order_acquire) == frame; waited += 100)
+		{
+			usleep(100);
+		}
+#endif
+		frame = counter.load(std::memory_order_acquire);
+		if (frame == client.frame) {
+			return 0;
+		}
+	}
+	client.frame = frame;
+	return frame;
+}
+
+/**
+ * @brief Queues a button macro, see macro_queue_t.
+ *
+ * Fails with scs_client_full when the plugin did not catch up with the
+ * queue yet.
+ */
+inline scs_client_status_t scs_client_submit_macro(scs_client_t& client, const macro_instruction_t* const instructions, const int count)
+{
+	if (count <= 0 || count > macroMaxInstructions) {
+		return scs_client_invalid;
+	}
+	macro_queue_t& queue = client.block->macros;
+	scs_u32_t tail = queue.tail.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		macro_entry_t& entry = queue.entries[tail % macroQueueLength];
+		const scs_u32_t sequence = entry.sequence.load(std::memory_order_acquire);
+		if (sequence == tail) {
+			if (queue.tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+				entry.instruction_count = static_cast<scs_u32_t>(count);
+				memcpy(entry.instructions, instructions, count * sizeof(macro_instruction_t));
+				entry.sequence.store(tail + 1, std::memory_order_release);
+				return scs_client_ok;
+			}
+		}
+		else if (static_cast<scs_s32_t>(sequence - tail) < 0) {
+			return scs_client_full;
+		}
+		else {
+			tail = queue.tail.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+/**
+ * @brief Replaces the trajectory, see trajectory_t.
+ *
+ * Writes the buffer the plugin is not sampling and switches to it, enabling
+ * the trajectory. Times use the clock of frame_sync_t::frame_time.
+ */
+inline scs_client_status_t scs_client_submit_trajectory(scs_client_t& client, const trajectory_knot_t* const knots, const int count, const trajectory_interpolation_t interpolation)
+{
+	if (count <= 0 || count > trajectoryKnotCount) {
+		return scs_client_invalid;
+	}
+	trajectory_t& trajectory = client.block->trajectory;
+	const scs_u32_t index = trajectory.active.load(std::memory_order_relaxed) ^ 1;
+	trajectory_buffer_t& buffer = trajectory.buffers[index & 1];
+
+	const scs_u32_t sequence = buffer.sequence.load(std::memory_order_relaxed);
+	buffer.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	buffer.knot_count = static_cast<scs_u32_t>(count);
+	memcpy(buffer.knots, knots, count * sizeof(trajectory_knot_t));
+	buffer.sequence.store(sequence + 2, std::memory_order_release);
+
+	trajectory.interpolation = interpolation;
+	trajectory.active.store(index & 1, std::memory_order_release);
+	trajectory.enabled.store(1, std::memory_order_release);
+	return scs_client_ok;
+}
+
+// Copies the telemetry snapshot, false when it kept changing during the copy.
+inline bool scs_client_read_telemetry(const scs_client_t& client, telemetry_values_t& values)
+{
+	const telemetry_snapshot_t& snapshot = client.block->telemetry;
+	for (int attempt = 0; attempt < 16; attempt++)
+	{
+		const scs_u32_t before = snapshot.sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;
+		}
+		memcpy(&values, &snapshot.values, sizeof(values));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (snapshot.sequence.load(std::memory_order_relaxed) == before) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Releases every input and the slot, then unmaps the block.
+inline void scs_client_close(scs_client_t& client)
+{
+	if (client.slot) {
+		scs_client_begin(client);
+		client.slot->ownership = 0;
+		client.slot->sequence.fetch_add(1, std::memory_order_release);
+		client.writing = false;
+		client.slot->id.store(0, std::memory_order_release);
+	}
+	scs_client_unmap(client);
+}
+
+#endif // INPUT_SEMANTICAL_SCS_CLIENT_H
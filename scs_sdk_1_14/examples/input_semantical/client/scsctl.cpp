@@ -0,0 +1,167 @@
+#define SCSCTL_BUILD
+
+#include <new>
+
+#include "scsctl.h"
+#include "scs_client.h"
+
+static_assert(sizeof(scsctl_telemetry_t) == sizeof(telemetry_values_t), "telemetry layout differs");
+static_assert(offsetof(scsctl_telemetry_t, position) == offsetof(telemetry_values_t, position), "telemetry layout differs");
+static_assert(SCSCTL_AXIS_COUNT == axisCount && SCSCTL_BUTTON_COUNT == buttonCount, "input counts differ");
+static_assert(SCSCTL_OK == scs_client_ok && SCSCTL_INVALID == scs_client_invalid, "status codes differ");
+
+struct scsctl
+{
+	scs_client_t client;
+
+	// Staged until the next commit.
+	float axes[axisCount];
+	scs_u32_t axis_mask;
+	scs_u64_t button_mask;
+	scs_u64_t buttons;
+	scs_u8_t groups[input_group_count];
+	scs_u32_t group_mask;
+	scs_u64_t released;
+};
+
+scsctl_t* scsctl_open(const char* name, uint32_t id, uint32_t priority, int* status)
+{
+	scsctl_t* const handle = new (std::nothrow) scsctl_t();
+	if (!handle) {
+		if (status) {
+			*status = SCSCTL_INVALID;
+		}
+		return NULL;
+	}
+	const scs_client_status_t result = scs_client_open(handle->client, name ? name : memname, id, priority);
+	if (status) {
+		*status = result;
+	}
+	if (result != scs_client_ok) {
+		delete handle;
+		return NULL;
+	}
+	return handle;
+}
+
+void scsctl_close(scsctl_t* handle)
+{
+	if (handle) {
+		scs_client_close(handle->client);
+		delete handle;
+	}
+}
+
+int scsctl_set_axes(scsctl_t* handle, const float* axes, uint32_t mask)
+{
+	if (!handle || (!axes && mask)) {
+		return SCSCTL_INVALID;
+	}
+	for (int i = 0; i < axisCount; i++)
+	{
+		if (mask & (1u << i)) {
+			handle->axes[i] = axes[i];
+		}
+	}
+	handle->axis_mask |= mask & ((1u << axisCount) - 1);
+	return SCSCTL_OK;
+}
+
+int scsctl_set_buttons_mask(scsctl_t* handle, uint64_t mask, uint64_t pressed)
+{
+	if (!handle) {
+		return SCSCTL_INVALID;
+	}
+	handle->buttons = (handle->buttons & ~mask) | (pressed & mask);
+	handle->button_mask |= mask & ((scs_u64_t(1) << buttonCount) - 1);
+	return SCSCTL_OK;
+}
+
+int scsctl_set_groups(scsctl_t* handle, const uint8_t* groups, uint32_t mask)
+{
+	if (!handle || (!groups && mask)) {
+		return SCSCTL_INVALID;
+	}
+	for (int i = 0; i < input_group_count; i++)
+	{
+		if (mask & (1u << i)) {
+			if (groups[i] > inputGroupRanges[i].count) {
+				return SCSCTL_INVALID;
+			}
+			handle->groups[i] = groups[i];
+		}
+	}
+	handle->group_mask |= mask & ((1u << input_group_count) - 1);
+	return SCSCTL_OK;
+}
+
+int scsctl_release(scsctl_t* handle, uint64_t inputs)
+{
+	if (!handle) {
+		return SCSCTL_INVALID;
+	}
+	handle->released |= inputs;
+	return SCSCTL_OK;
+}
+
+int scsctl_commit(scsctl_t* handle)
+{
+	if (!handle) {
+		return SCSCTL_INVALID;
+	}
+	scs_client_t& client = handle->client;
+	scs_client_begin(client);
+	scs_client_release(client, handle->released);
+	for (int i = 0; i < axisCount; i++)
+	{
+		if (handle->axis_mask & (1u << i)) {
+			scs_client_set_axis(client, static_cast<axis_t>(i), handle->axes[i]);
+		}
+	}
+	if (handle->button_mask) {
+		scs_client_set_buttons(client, handle->button_mask, handle->buttons);
+	}
+	for (int i = 0; i < input_group_count; i++)
+	{
+		if (handle->group_mask & (1u << i)) {
+			scs_client_set_group(client, static_cast<input_group_t>(i), handle->groups[i]);
+		}
+	}
+	scs_client_commit(client);
+
+	handle->axis_mask = 0;
+	handle->button_mask = 0;
+	handle->group_mask = 0;
+	handle->released = 0;
+	return SCSCTL_OK;
+}
+
+int scsctl_frame(scsctl_t* handle, const float* axes, uint32_t axis_mask, uint64_t button_mask, uint64_t pressed)
+{
+	int status = scsctl_set_axes(handle, axes, axis_mask);
+	if (status == SCSCTL_OK) {
+		status = scsctl_set_buttons_mask(handle, button_mask, pressed);
+	}
+	if (status == SCSCTL_OK) {
+		status = scsctl_commit(handle);
+	}
+	return status;
+}
+
+uint32_t scsctl_wait_frame(scsctl_t* handle, uint32_t timeout)
+{
+	return handle ? scs_client_wait_frame(handle->client, timeout) : 0;
+}
+
+int scsctl_read_telemetry(scsctl_t* handle, scsctl_telemetry_t* telemetry)
+{
+	if (!handle || !telemetry) {
+		return SCSCTL_INVALID;
+	}
+	telemetry_values_t values;
+	if (!scs_client_read_telemetry(handle->client, values)) {
+		return SCSCTL_TORN;
+	}
+	memcpy(telemetry, &values, sizeof(values));
+	return SCSCTL_OK;
+}
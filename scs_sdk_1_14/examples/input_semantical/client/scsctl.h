@@ -0,0 +1,104 @@
+/**
+ * @brief Flat C interface of the producer client for FFI consumers.
+ *
+ * Wraps scs_client.h in a shared library with plain C types, so Python
+ * ctypes, C# or Rust can drive the plugin without knowing the layout of the
+ * control block. Values are staged in the handle and published together by
+ * scsctl_commit, scsctl_frame stages and commits a whole frame in one call.
+ * Functions returning int return one of the SCSCTL_* status codes.
+ */
+#ifndef SCSCTL_H
+#define SCSCTL_H
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#  ifdef SCSCTL_BUILD
+#    define SCSCTL_API __declspec(dllexport)
+#  else
+#    define SCSCTL_API __declspec(dllimport)
+#  endif
+#else
+#  define SCSCTL_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCSCTL_OK		0
+#define SCSCTL_NOT_FOUND	1	/* no plugin created the block yet */
+#define SCSCTL_BAD_LAYOUT	2	/* plugin built with another layout */
+#define SCSCTL_NO_SLOT		3	/* all producer slots are taken */
+#define SCSCTL_FULL		4	/* the macro queue is full */
+#define SCSCTL_INVALID		5	/* bad argument */
+#define SCSCTL_TORN		6	/* the telemetry kept changing during the read */
+
+#define SCSCTL_AXIS_COUNT	4
+#define SCSCTL_BUTTON_COUNT	38
+
+typedef struct scsctl scsctl_t;
+
+/* Same layout as telemetry_values_t in control_layout.h. */
+typedef struct scsctl_telemetry
+{
+	uint64_t simulation_time;	/* microseconds */
+	uint32_t frames;
+	uint32_t game_time;		/* minutes */
+	uint32_t paused;
+	int32_t gear;
+	float speed;			/* m/s */
+	float input_steering;
+	float input_throttle;
+	float input_brake;
+	float input_clutch;
+	float effective_steering;
+	float effective_throttle;
+	float effective_brake;
+	float effective_clutch;
+	float rpm;
+	float angular_velocity[3];	/* rotations per second, vehicle space */
+	float heading;
+	float pitch;
+	float roll;
+	double position[3];
+} scsctl_telemetry_t;
+
+/*
+ * Maps the control block (name NULL selects Local\SCSControls) and claims a
+ * producer slot with the nonzero id. Returns NULL with the reason in status.
+ */
+SCSCTL_API scsctl_t* scsctl_open(const char* name, uint32_t id, uint32_t priority, int* status);
+
+/* Releases every input and the slot. */
+SCSCTL_API void scsctl_close(scsctl_t* handle);
+
+/* Stages axes[i] for every axis with bit i of mask set (steering, aforward, abackward, clutch). */
+SCSCTL_API int scsctl_set_axes(scsctl_t* handle, const float* axes, uint32_t mask);
+
+/* Stages button i as bit i of pressed for every bit i set in mask, buttons numbered from pause. */
+SCSCTL_API int scsctl_set_buttons_mask(scsctl_t* handle, uint64_t mask, uint64_t pressed);
+
+/* Stages the button groups (wipers, camera, gear), 0 = individual buttons, n = only member n - 1. */
+SCSCTL_API int scsctl_set_groups(scsctl_t* handle, const uint8_t* groups, uint32_t mask);
+
+/* Stops controlling the inputs with their bit set, numbered like the inputs (axes first). */
+SCSCTL_API int scsctl_release(scsctl_t* handle, uint64_t inputs);
+
+/* Publishes everything staged since the previous commit. */
+SCSCTL_API int scsctl_commit(scsctl_t* handle);
+
+/* scsctl_set_axes, scsctl_set_buttons_mask and scsctl_commit in one call. */
+SCSCTL_API int scsctl_frame(scsctl_t* handle, const float* axes, uint32_t axis_mask, uint64_t button_mask, uint64_t pressed);
+
+/* Waits for the next frame start, returns the frame number or 0 after timeout microseconds. */
+SCSCTL_API uint32_t scsctl_wait_frame(scsctl_t* handle, uint32_t timeout);
+
+/* Copies the telemetry the plugin published at the end of the last telemetry frame. */
+SCSCTL_API int scsctl_read_telemetry(scsctl_t* handle, scsctl_telemetry_t* telemetry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCSCTL_H */
@@ -0,0 +1,496 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "platform.h"
+
+const int configLineSize = 512;
+const int configFileSize = 65536;
+
+// The file is read in one go so that reloading from the input callback
+// does not go through stdio, which allocates its buffers.
+static char fileText[configFileSize];
+
+static void copy_string(char* const destination, const char* const source)
+{
+	strncpy(destination, source, configNameSize - 1);
+	destination[configNameSize - 1] = '\0';
+}
+
+static char* trim(char* text)
+{
+	while (isspace(static_cast<unsigned char>(*text))) {
+		text++;
+	}
+	char* end = text + strlen(text);
+	while (end > text && isspace(static_cast<unsigned char>(end[-1]))) {
+		end--;
+	}
+	*end = '\0';
+	return text;
+}
+
+static bool parse_bool(const char* const value, bool& result)
+{
+	if (strcmp(value, "1") == 0 || strcmp(value, "on") == 0 || strcmp(value, "true") == 0 || strcmp(value, "yes") == 0) {
+		result = true;
+		return true;
+	}
+	if (strcmp(value, "0") == 0 || strcmp(value, "off") == 0 || strcmp(value, "false") == 0 || strcmp(value, "no") == 0) {
+		result = false;
+		return true;
+	}
+	return false;
+}
+
+static bool parse_float(const char* const value, float& result)
+{
+	char* end;
+	result = static_cast<float>(strtod(value, &end));
+	return end != value && *end == '\0';
+}
+
+static bool parse_u32(const char* const value, scs_u32_t& result)
+{
+	char* end;
+	const unsigned long parsed = strtoul(value, &end, 10);
+	result = static_cast<scs_u32_t>(parsed);
+	return end != value && *end == '\0';
+}
+
+// Space separated input:output pairs, e.g. "0:0 0.5:0.3 1:1".
+static bool parse_points(const char* value, curve_params_t& curve)
+{
+	int count = 0;
+	while (*value)
+	{
+		char* end;
+		const float input = static_cast<float>(strtod(value, &end));
+		if (end == value || *end != ':' || count == curveMaxPoints) {
+			return false;
+		}
+		value = end + 1;
+		const float output = static_cast<float>(strtod(value, &end));
+		if (end == value) {
+			return false;
+		}
+		curve.points[count][0] = input;
+		curve.points[count][1] = output;
+		count++;
+		value = end;
+		while (isspace(static_cast<unsigned char>(*value))) {
+			value++;
+		}
+	}
+	curve.point_count = count;
+	return true;
+}
+
+static bool parse_log_level(const char* const value, log_level_t& result)
+{
+	const char* const names[] = { "none", "error", "info", "debug" };
+	for (int i = 0; i < 4; i++)
+	{
+		if (strcmp(value, names[i]) == 0) {
+			result = static_cast<log_level_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool parse_namespace(const char* const value, memory_namespace_t& result)
+{
+	const char* const names[] = { "shared", "game", "instance" };
+	for (int i = 0; i < 3; i++)
+	{
+		if (strcmp(value, names[i]) == 0) {
+			result = static_cast<memory_namespace_t>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+// The game accepts only letters, digits, underscores, spaces and dots.
+static bool parse_display_name(const char* const value, char* const result)
+{
+	const size_t length = strlen(value);
+	if (length == 0 || length >= static_cast<size_t>(genericNameSize)) {
+		return false;
+	}
+	for (size_t i = 0; i < length; i++)
+	{
+		const unsigned char c = static_cast<unsigned char>(value[i]);
+		if (!isalnum(c) && c != '_' && c != ' ' && c != '.') {
+			return false;
+		}
+	}
+	memcpy(result, value, length + 1);
+	return true;
+}
+
+// Index from a key like "axis3" with the given prefix.
+static bool parse_index(const char* const key, const char* const prefix, const int count, int& index)
+{
+	const size_t length = strlen(prefix);
+	if (strncmp(key, prefix, length) != 0 || !isdigit(static_cast<unsigned char>(key[length]))) {
+		return false;
+	}
+	scs_u32_t parsed;
+	if (!parse_u32(key + length, parsed) || parsed >= static_cast<scs_u32_t>(count)) {
+		return false;
+	}
+	index = static_cast<int>(parsed);
+	return true;
+}
+
+static int find_input(const scs_input_device_input_t* const inputs, const int count, const char* const name)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (strcmp(inputs[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static bool apply_value(config_t& config, const scs_input_device_input_t* const inputs, const char* const section, const char* const key, const char* const value)
+{
+	if (strcmp(section, "shared_memory") == 0) {
+		if (strcmp(key, "name") == 0 && *value) {
+			copy_string(config.memory_name, value);
+			return true;
+		}
+		if (strcmp(key, "namespace") == 0) {
+			return parse_namespace(value, config.memory_namespace);
+		}
+		if (strcmp(key, "suffix") == 0) {
+			copy_string(config.memory_suffix, value);
+			return true;
+		}
+		return false;
+	}
+
+	if (strcmp(section, "device") == 0) {
+		if (strcmp(key, "name") == 0 && *value) {
+			copy_string(config.device_name, value);
+			return true;
+		}
+		if (strcmp(key, "display_name") == 0 && *value) {
+			copy_string(config.display_name, value);
+			return true;
+		}
+		return false;
+	}
+
+	if (strcmp(section, "generic") == 0) {
+		generic_config_t& generic = config.generic;
+		int index;
+		if (strcmp(key, "enabled") == 0) {
+			return parse_bool(value, generic.enabled);
+		}
+		if (strcmp(key, "name") == 0 && *value) {
+			copy_string(generic.device_name, value);
+			return true;
+		}
+		if (strcmp(key, "display_name") == 0 && *value) {
+			copy_string(generic.display_name, value);
+			return true;
+		}
+		if (strcmp(key, "axes") == 0) {
+			return parse_u32(value, generic.axes) && generic.axes <= static_cast<scs_u32_t>(genericAxisCount);
+		}
+		if (strcmp(key, "buttons") == 0) {
+			return parse_u32(value, generic.buttons) && generic.buttons <= static_cast<scs_u32_t>(genericButtonCount);
+		}
+		if (parse_index(key, "axis", genericAxisCount, index)) {
+			return parse_display_name(value, generic.axis_names[index]);
+		}
+		if (parse_index(key, "button", genericButtonCount, index)) {
+			return parse_display_name(value, generic.button_names[index]);
+		}
+		return false;
+	}
+
+	if (strcmp(section, "inputs") == 0) {
+		const int input = find_input(inputs, inputCount, key);
+		return input >= 0 && parse_bool(value, config.input_enabled[input]);
+	}
+
+	if (strcmp(section, "map") == 0) {
+		const int input = find_input(inputs, inputCount, key);
+		return input >= 0 && input_map_parse(config.map[input], input, value, inputs);
+	}
+
+	if (strncmp(section, "curve.", 6) == 0) {
+		const int axis = find_input(inputs, axisCount, section + 6);
+		if (axis < 0) {
+			return false;
+		}
+		curve_params_t& curve = config.curves[axis];
+		if (strcmp(key, "deadzone") == 0) {
+			return parse_float(value, curve.deadzone);
+		}
+		if (strcmp(key, "saturation") == 0) {
+			return parse_float(value, curve.saturation);
+		}
+		if (strcmp(key, "expo") == 0) {
+			return parse_float(value, curve.expo);
+		}
+		if (strcmp(key, "points") == 0) {
+			return parse_points(value, curve);
+		}
+		return false;
+	}
+
+	if (strcmp(section, "failsafe") == 0) {
+		return strcmp(key, "timeout_ms") == 0 && parse_u32(value, config.failsafe_timeout);
+	}
+
+	if (strcmp(section, "producers") == 0) {
+		return strcmp(key, "timeout_ms") == 0 && parse_u32(value, config.producer_timeout);
+	}
+
+	if (strcmp(section, "override") == 0) {
+		override_config_t& override_config = config.human_override;
+		if (strcmp(key, "enabled") == 0) {
+			return parse_bool(value, override_config.enabled);
+		}
+		if (strcmp(key, "steering_threshold") == 0) {
+			return parse_float(value, override_config.steering_threshold);
+		}
+		if (strcmp(key, "pedal_threshold") == 0) {
+			return parse_float(value, override_config.pedal_threshold);
+		}
+		if (strcmp(key, "release_threshold") == 0) {
+			return parse_float(value, override_config.release_threshold);
+		}
+		if (strcmp(key, "release_ms") == 0) {
+			return parse_u32(value, override_config.release_time);
+		}
+		if (strcmp(key, "return_ms") == 0) {
+			return parse_u32(value, override_config.return_time);
+		}
+		if (strcmp(key, "authority") == 0) {
+			return parse_float(value, override_config.authority);
+		}
+		if (strcmp(key, "steering_sign") == 0) {
+			return parse_float(value, override_config.steering_sign) && (override_config.steering_sign == 1.0f || override_config.steering_sign == -1.0f);
+		}
+		return false;
+	}
+
+	if (strcmp(section, "rules") == 0) {
+		const int input = find_input(inputs, inputCount, key);
+		if (input < 0 || config.rules.count == ruleMaxCount) {
+			return false;
+		}
+		char error[128];
+		if (!rule_compile(value, input, config.rules.rules[config.rules.count], inputs, error, sizeof(error))) {
+			if (config.error[0] == '\0') {
+				snprintf(config.error, sizeof(config.error), "rule %s: %s", key, error);
+			}
+			return true;
+		}
+		config.rules.count++;
+		return true;
+	}
+
+	if (strcmp(section, "calibration") == 0) {
+		if (strcmp(key, "file") == 0 && *value) {
+			copy_string(config.calibration_file, value);
+			return true;
+		}
+		return strcmp(key, "enabled") == 0 && parse_bool(value, config.calibration_enabled);
+	}
+
+	if (strcmp(section, "steering_calibration") == 0) {
+		int row;
+		char extra;
+		if (sscanf(key, "speed%d%c", &row, &extra) != 1 || row < 0 || row >= calibrationSpeedBins) {
+			return false;
+		}
+		const char* text = value;
+		for (int i = 0; i < calibrationSteeringBins; i++)
+		{
+			char* end;
+			config.steering_table.inputs[row][i] = static_cast<float>(strtod(text, &end));
+			if (end == text) {
+				return false;
+			}
+			text = end;
+		}
+		config.steering_table.rows_loaded |= 1u << row;
+		return true;
+	}
+
+	if (strcmp(section, "log") == 0) {
+		if (strcmp(key, "file") == 0 && *value) {
+			copy_string(config.log_file, value);
+			return true;
+		}
+		return strcmp(key, "level") == 0 && parse_log_level(value, config.log_level);
+	}
+
+	if (strcmp(section, "reload") == 0) {
+		return strcmp(key, "check_frames") == 0 && parse_u32(value, config.reload_frames);
+	}
+
+	if (strcmp(section, "memory") == 0) {
+		memory_config_t& memory = config.memory;
+		if (strcmp(key, "prefault") == 0) {
+			return parse_bool(value, memory.prefault);
+		}
+		if (strcmp(key, "lock") == 0) {
+			return parse_bool(value, memory.lock);
+		}
+		return strcmp(key, "large_pages") == 0 && parse_bool(value, memory.large_pages);
+	}
+
+	if (strcmp(section, "recording") == 0) {
+		if (strcmp(key, "path") == 0) {
+			copy_string(config.recording.path, value);
+			return true;
+		}
+		return strcmp(key, "enabled") == 0 && parse_bool(value, config.recording.enabled);
+	}
+
+	return false;
+}
+
+const char* config_path(void)
+{
+	const char* const path = getenv(configPathVariable);
+	return (path && *path) ? path : defaultConfigPath;
+}
+
+void config_default(config_t& config)
+{
+	memset(&config, 0, sizeof(config));
+	copy_string(config.memory_name, memname);
+	config.memory_namespace = memory_namespace_shared;
+	copy_string(config.device_name, "laneassist");
+	copy_string(config.display_name, "ETS2 Lane Assist");
+	for (int i = 0; i < inputCount; i++)
+	{
+		config.input_enabled[i] = true;
+	}
+	copy_string(config.generic.device_name, "laneassist_generic");
+	copy_string(config.generic.display_name, "ETS2LA Generic");
+	config.generic.axes = 4;
+	config.generic.buttons = 16;
+	for (int i = 0; i < genericAxisCount; i++)
+	{
+		snprintf(config.generic.axis_names[i], genericNameSize, "Axis %d", i);
+	}
+	for (int i = 0; i < genericButtonCount; i++)
+	{
+		snprintf(config.generic.button_names[i], genericNameSize, "Button %d", i);
+	}
+	input_map_default(config.map);
+	for (int i = 0; i < axisCount; i++)
+	{
+		curve_default(config.curves[i]);
+		curve_compile(config.curves[i], config.tables[i]);
+	}
+	config.producer_timeout = defaultProducerTimeout;
+	config.human_override.enabled = false;
+	config.human_override.steering_threshold = 0.15f;
+	config.human_override.pedal_threshold = 0.1f;
+	config.human_override.release_threshold = 0.05f;
+	config.human_override.release_time = 1000;
+	config.human_override.return_time = 500;
+	config.human_override.authority = 0.0f;
+	config.human_override.steering_sign = 1.0f;
+	copy_string(config.calibration_file, defaultCalibrationPath);
+	config.calibration_enabled = true;
+	copy_string(config.log_file, "input.log");
+	config.log_level = log_level_info;
+	config.reload_frames = defaultReloadFrames;
+	config.memory.prefault = true;
+}
+
+// With only_section set, lines of every other section are ignored.
+static bool parse_file(const char* const path, config_t& config, const scs_input_device_input_t* const inputs, const char* const only_section)
+{
+	const long size = file_read(path, fileText, sizeof(fileText));
+	if (size < 0) {
+		return false;
+	}
+	if (size == configFileSize - 1) {
+		snprintf(config.error, sizeof(config.error), "%s: only the first %d bytes are used", path, configFileSize - 1);
+	}
+
+	char line[configLineSize];
+	char section[configLineSize] = "";
+	int number = 0;
+	for (const char* next = fileText; *next; )
+	{
+		const char* const end = strchr(next, '\n');
+		const size_t length = end ? static_cast<size_t>(end - next) : strlen(next);
+		const size_t copied = length < sizeof(line) - 1 ? length : sizeof(line) - 1;
+		memcpy(line, next, copied);
+		line[copied] = '\0';
+		next += end ? length + 1 : length;
+
+		number++;
+		char* text = trim(line);
+		if (*text == '\0' || *text == ';' || *text == '#') {
+			continue;
+		}
+
+		if (*text == '[') {
+			char* const end = strchr(text, ']');
+			if (end) {
+				*end = '\0';
+				strcpy(section, trim(text + 1));
+				continue;
+			}
+		}
+		else {
+			char* const equals = strchr(text, '=');
+			if (equals && (!only_section || strcmp(section, only_section) == 0)) {
+				*equals = '\0';
+				if (apply_value(config, inputs, section, trim(text), trim(equals + 1))) {
+					continue;
+				}
+			}
+		}
+
+		if (config.error[0] == '\0') {
+			snprintf(config.error, sizeof(config.error), "%s:%d: ignored \"%s\"", path, number, text);
+		}
+	}
+	return true;
+}
+
+bool config_load(const char* const path, config_t& config, const scs_input_device_input_t* const inputs)
+{
+	config_default(config);
+
+	// Taken before reading so that a write during the read triggers another load.
+	config.modification_time = file_modification_time(path);
+
+	const bool loaded = parse_file(path, config, inputs, NULL);
+
+	for (int i = 0; i < axisCount; i++)
+	{
+		curve_compile(config.curves[i], config.tables[i]);
+	}
+
+	// The calibration is optional and only used when complete. The plugin
+	// writes that file, it may only fill in the calibration table.
+	parse_file(config.calibration_file, config, inputs, "steering_calibration");
+	config.steering_table.valid = config.steering_table.rows_loaded == (1u << calibrationSpeedBins) - 1;
+	return loaded;
+}
+
+char* config_file_buffer(size_t& size)
+{
+	size = sizeof(fileText);
+	return fileText;
+}
@@ -0,0 +1,121 @@
+/**
+ * @brief Plugin configuration.
+ *
+ * Read from an INI style file (see readme.md) when the plugin loads and
+ * again whenever the file changes. Everything has a default, so a missing
+ * file gives the same behavior as the built-in settings.
+ */
+#ifndef INPUT_SEMANTICAL_CONFIG_H
+#define INPUT_SEMANTICAL_CONFIG_H
+
+#include "control_layout.h"
+#include "input_map.h"
+#include "instance_registry.h"
+#include "log.h"
+#include "response_curve.h"
+#include "rule_vm.h"
+#include "steering_calibration.h"
+
+#include "scssdk_input.h"
+
+const char* const defaultConfigPath = "input_semantical.ini";
+const char* const configPathVariable = "SCS_INPUT_CONFIG";
+const scs_u32_t defaultReloadFrames = 60;
+
+const int configNameSize = 256;
+const int configErrorSize = 256;
+
+struct override_config_t
+{
+	bool enabled;
+	float steering_threshold;	// deviation starting an override
+	float pedal_threshold;
+	float release_threshold;	// deviation below which the driver counts as hands off
+	scs_u32_t release_time;		// milliseconds below the release threshold before handing back
+	scs_u32_t return_time;		// milliseconds to ramp the authority back to one
+	float authority;		// share of the plugin command kept during an override, 0 = yield
+	float steering_sign;		// 1 or -1, truck.input.steering relative to the steering axis
+};
+
+const int genericNameSize = 32;
+
+// The generic device, see generic_inputs_t.
+struct generic_config_t
+{
+	bool enabled;
+	char device_name[configNameSize];
+	char display_name[configNameSize];
+	scs_u32_t axes;				// registered axes, at most genericAxisCount
+	scs_u32_t buttons;			// registered buttons, at most genericButtonCount
+	char axis_names[genericAxisCount][genericNameSize];	// shown in the game UI
+	char button_names[genericButtonCount][genericNameSize];
+};
+
+struct memory_config_t
+{
+	bool prefault;			// touch every page of the regions at init
+	bool lock;			// and keep them in memory
+	bool large_pages;		// back the recording ring with huge/large pages
+};
+
+struct recording_config_t
+{
+	bool enabled;				// record telemetry while driving
+	char path[configNameSize];		// directory of the recordings, empty = working directory
+};
+
+struct config_t
+{
+	char memory_name[configNameSize];	// base name, see memory_namespace
+	memory_namespace_t memory_namespace;
+	char memory_suffix[configNameSize];	// appended to tell instances apart
+	char device_name[configNameSize];
+	char display_name[configNameSize];
+	bool input_enabled[inputCount];
+	generic_config_t generic;
+	input_map_entry_t map[inputCount];	// source slot of every input
+
+	curve_params_t curves[axisCount];
+	curve_table_t tables[axisCount];	// compiled from curves by config_load
+
+	scs_u32_t failsafe_timeout;		// milliseconds without a heartbeat change, 0 = off
+	scs_u32_t producer_timeout;		// milliseconds until a producer slot stops counting
+	override_config_t human_override;
+
+	rule_set_t rules;
+
+	char calibration_file[configNameSize];
+	bool calibration_enabled;		// apply the table when one is loaded
+	steering_table_t steering_table;	// loaded from calibration_file
+
+	char log_file[configNameSize];
+	log_level_t log_level;
+
+	scs_u32_t reload_frames;		// frames between checks of the file, 0 = never
+
+	memory_config_t memory;
+	recording_config_t recording;
+
+	scs_u64_t modification_time;		// of the file this was loaded from
+	char error[configErrorSize];		// first problem found in the file
+};
+
+// Path of the configuration file, the environment variable overrides the default.
+const char* config_path(void);
+
+void config_default(config_t& config);
+
+/**
+ * @brief Loads the configuration over the defaults.
+ *
+ * Unknown keys and malformed values are skipped and the first of them is
+ * described in error. Also loads the steering calibration file named by the
+ * configuration. Returns false when the configuration file can not be read,
+ * leaving the defaults in place.
+ */
+bool config_load(const char* const path, config_t& config, const scs_input_device_input_t* const inputs);
+
+// The buffer config_load reads the files into, for pre-faulting it.
+char* config_file_buffer(size_t& size);
+
+#endif // INPUT_SEMANTICAL_CONFIG_H
@@ -0,0 +1,704 @@
+/**
+ * @brief Layout of the shared memory control block.
+ *
+ * Shared by the plugin and the tools. Producers write the axes as floats
+ * followed by the buttons as one byte bools ("ffff38?" in Python struct
+ * notation), in the order of the table in readme.md. Everything after the
+ * first 64 bytes is optional and producers only writing the axes and
+ * buttons can keep mapping just those.
+ */
+#ifndef INPUT_SEMANTICAL_CONTROL_LAYOUT_H
+#define INPUT_SEMANTICAL_CONTROL_LAYOUT_H
+
+#include <stddef.h>
+#include <atomic>
+
+#include "scssdk.h"
+
+const int axisCount = 4;
+const int buttonCount = 38;
+const int inputCount = axisCount + buttonCount;
+const char* const memname = "Local\\SCSControls";
+
+const size_t buttonSize = buttonCount * sizeof(bool);
+const size_t axisSize = axisCount * sizeof(float);
+
+/**
+ * Every region starts on a cache line of its own, and within a region the
+ * fields written by the producers, by the plugin and by the tools are kept
+ * on separate lines as well (the alignas(cacheLineSize) members below), so
+ * no store of one side invalidates a line the other side keeps writing.
+ * Only the handoff fields of the seqlocks and the macro queue are shared
+ * by design.
+ */
+const size_t cacheLineSize = 64;
+
+// Indices of the axes in control_block_t::axes.
+enum axis_t
+{
+	axis_steering,
+	axis_aforward,
+	axis_abackward,
+	axis_clutch
+};
+
+// Indices of the buttons in control_block_t::buttons, the input slot is
+// axisCount + index.
+enum button_t
+{
+	button_pause,
+	button_parkingbrake,
+	button_wipers,
+	button_cruiectrl,
+	button_cruiectrlinc,
+	button_cruiectrldec,
+	button_cruiectrlres,
+	button_light,
+	button_hblight,
+	button_lblinker,
+	button_rblinker,
+	button_quickpark,
+	button_drive,
+	button_reverse,
+	button_cycl_zoom,
+	button_tripreset,
+	button_wipersback,
+	button_wipers0,
+	button_wipers1,
+	button_wipers2,
+	button_wipers3,
+	button_wipers4,
+	button_horn,
+	button_airhorn,
+	button_lighthorn,
+	button_cam1,
+	button_cam2,
+	button_cam3,
+	button_cam4,
+	button_cam5,
+	button_cam6,
+	button_cam7,
+	button_cam8,
+	button_mapzoom_in,
+	button_mapzoom_out,
+	button_accmode,
+	button_showmirrors,
+	button_flasher4way
+};
+
+// Names of the inputs by slot, as registered with the game.
+const char* const inputNames[inputCount] = {
+	"steering", "aforward", "abackward", "clutch", "pause", "parkingbrake",
+	"wipers", "cruiectrl", "cruiectrlinc", "cruiectrldec", "cruiectrlres",
+	"light", "hblight", "lblinker", "rblinker", "quickpark", "drive", "reverse",
+	"cycl_zoom", "tripreset", "wipersback", "wipers0", "wipers1", "wipers2",
+	"wipers3", "wipers4", "horn", "airhorn", "lighthorn", "cam1", "cam2", "cam3",
+	"cam4", "cam5", "cam6", "cam7", "cam8", "mapzoom_in", "mapzoom_out",
+	"accmode", "showmirrors", "flasher4way"
+};
+
+// Groups of mutually exclusive buttons, see control_block_t::groups.
+enum input_group_t
+{
+	input_group_wipers,	// wipers0 - wipers4
+	input_group_camera,	// cam1 - cam8
+	input_group_gear,	// drive, reverse
+	input_group_count
+};
+
+struct input_group_range_t
+{
+	int first;		// slot of the first member
+	int count;
+};
+
+const input_group_range_t inputGroupRanges[input_group_count] = {
+	{ 21, 5 },
+	{ 29, 8 },
+	{ 16, 2 }
+};
+
+// Events accompanying the frame handshake counters (see shared_event_t).
+const char* const frameEventSuffix = ".frame";
+const char* const ackEventSuffix = ".ack";
+const char* const activityEventSuffix = ".activity";
+
+// Lists the control blocks of all running plugin instances, see registry_t.
+const char* const registryName = "Local\\SCSControls.registry";
+
+const int lockstepHistogramBuckets = 16;
+const scs_u32_t defaultLockstepTimeout = 20000;
+const scs_u32_t defaultLockstepSpin = 50;
+
+/**
+ * @brief Frame handshake between the plugin and the producers.
+ *
+ * At the start of every frame the plugin increments frame and signals it.
+ * In lockstep mode it then waits until the producer stores the same number
+ * into ack_frame after committing the command for that frame, or until the
+ * timeout passes, in which case the frame uses whatever is in the block and
+ * counts as a miss.
+ */
+struct alignas(cacheLineSize) frame_sync_t
+{
+	// Written by the plugin.
+	std::atomic<scs_u32_t> frame;
+	scs_u32_t _padding0;
+	std::atomic<scs_u64_t> frame_time;		// monotonic_time_us() at the frame start, or the host clock
+
+	// Written by the producer.
+	alignas(cacheLineSize) std::atomic<scs_u32_t> lockstep;	// nonzero enables lockstep
+	std::atomic<scs_u32_t> lockstep_timeout;	// microseconds, 0 selects the default
+	std::atomic<scs_u32_t> ack_frame;
+	scs_u32_t _padding1;
+
+	// Written by the plugin. Bucket i counts waits of [2^i - 1, 2^(i+1) - 1) us.
+	alignas(cacheLineSize) std::atomic<scs_u32_t> lockstep_waits;
+	std::atomic<scs_u32_t> lockstep_misses;
+	std::atomic<scs_u32_t> wait_histogram[lockstepHistogramBuckets];
+};
+
+const int trajectoryKnotCount = 32;
+const scs_u32_t defaultTrajectoryExtrapolation = 100000;
+
+enum trajectory_interpolation_t
+{
+	trajectory_interpolation_linear,
+	trajectory_interpolation_hermite
+};
+
+struct trajectory_knot_t
+{
+	scs_u64_t time;		// monotonic_time_us() clock, same as frame_sync_t::frame_time
+	float steering;		// <-1,1>
+	float throttle;		// <0,1>
+	float brake;		// <0,1>
+	float _padding;
+};
+
+struct trajectory_buffer_t
+{
+	std::atomic<scs_u32_t> sequence;	// odd while the producer writes the buffer
+	scs_u32_t knot_count;
+	trajectory_knot_t knots[trajectoryKnotCount];	// ascending time
+};
+
+/**
+ * @brief Short trajectory sampled by the plugin at the start of every frame.
+ *
+ * The producer fills the buffer which is not active (sequence odd while
+ * writing, even when done) and then stores its index into active. While
+ * enabled, the sampled steering, throttle and brake replace the steering,
+ * aforward and abackward axes. Past the last knot the trajectory is
+ * extrapolated for at most max_extrapolation microseconds and then held.
+ */
+struct alignas(cacheLineSize) trajectory_t
+{
+	// Written by the producer.
+	std::atomic<scs_u32_t> enabled;
+	std::atomic<scs_u32_t> active;
+	scs_u32_t interpolation;		// trajectory_interpolation_t
+	scs_u32_t max_extrapolation;		// microseconds, 0 selects the default
+	trajectory_buffer_t buffers[2];
+
+	// Written by the plugin.
+	alignas(cacheLineSize) std::atomic<scs_u32_t> samples;
+	std::atomic<scs_u32_t> torn_reads;
+	std::atomic<scs_u32_t> extrapolated;
+};
+
+struct pid_gains_t
+{
+	float kp;
+	float ki;
+	float kd;			// applied to the measurement, not the error
+	float feedforward;		// multiplied by the target
+	float integral_limit;		// bound of the integral term
+	float output_min;
+	float output_max;
+	float rate_limit;		// maximal output change per second, 0 = unlimited
+};
+
+struct pid_state_t
+{
+	float target;
+	float measured;
+	float error;
+	float p;
+	float i;
+	float d;
+	float feedforward;
+	float output;
+};
+
+/**
+ * @brief Optional steering and speed controllers closed inside the plugin.
+ *
+ * The steering controller tracks target_curvature (1/m, positive to the left)
+ * against the yaw rate divided by the speed and drives the steering axis. The
+ * speed controller tracks target_speed (m/s) and drives aforward with positive
+ * and abackward with negative output. Both run at the start of every frame
+ * from the plugin's own telemetry and take precedence over a trajectory.
+ */
+struct alignas(cacheLineSize) controller_t
+{
+	// Written by the producer.
+	std::atomic<scs_u32_t> steering_enabled;
+	std::atomic<scs_u32_t> speed_enabled;
+	float target_curvature;
+	float target_speed;
+	pid_gains_t steering_gains;
+	pid_gains_t speed_gains;
+
+	// Written by the plugin.
+	alignas(cacheLineSize) pid_state_t steering;
+	pid_state_t speed;
+	std::atomic<scs_u32_t> updates;
+};
+
+const int producerSlotCount = 8;
+const scs_u32_t defaultProducerTimeout = 500;
+
+/**
+ * @brief Command of one of several independent producers.
+ *
+ * A producer claims a free slot by swapping id from 0 to its own nonzero id,
+ * then writes priority, ownership (bit i set for every slot i it wants to
+ * control, numbered like the inputs) and its values between making sequence
+ * odd and even again, and increments heartbeat at least once per timeout.
+ * For every input the live producer with the highest priority owning it
+ * wins, inputs owned by none come from the axes and buttons at the start of
+ * the block.
+ */
+struct alignas(cacheLineSize) producer_slot_t
+{
+	// Written by the producer.
+	std::atomic<scs_u32_t> sequence;	// odd while the producer writes the slot
+	std::atomic<scs_u32_t> id;		// 0 = free
+	scs_u32_t priority;			// higher wins
+	std::atomic<scs_u32_t> heartbeat;
+	scs_u64_t ownership;
+	float axes[axisCount];
+	bool buttons[buttonCount];
+	scs_u8_t groups[input_group_count];
+
+	// Written by the plugin.
+	alignas(cacheLineSize) scs_u64_t granted;	// inputs this producer won in the last frame
+	std::atomic<scs_u32_t> live;
+};
+
+// Channels of the human override, see override_t::active.
+enum override_channel_t
+{
+	override_channel_steering,
+	override_channel_pedals,		// throttle and brake
+	override_channel_count
+};
+
+/**
+ * @brief Human override state published by the plugin.
+ *
+ * The plugin compares truck.input.* from the telemetry with what it sent.
+ * When the driver moves the wheel or a pedal past the configured threshold
+ * it scales its own command on that channel down to the configured
+ * authority and ramps back once the driver has let go for long enough.
+ */
+struct alignas(cacheLineSize) override_t
+{
+	std::atomic<scs_u32_t> active;		// bit per override_channel_t
+	std::atomic<scs_u32_t> takeovers;	// number of overrides so far
+	float authority[override_channel_count];	// <0,1> share of the plugin command sent
+	float deviation[override_channel_count];	// last input minus command
+};
+
+enum calibration_command_t
+{
+	calibration_command_none,
+	calibration_command_observe,	// collect samples while the producer drives
+	calibration_command_sweep,	// the plugin steps the steering through its range
+	calibration_command_finish,	// fit and store the table
+	calibration_command_cancel
+};
+
+enum calibration_state_t
+{
+	calibration_state_idle,
+	calibration_state_observing,
+	calibration_state_sweeping,
+	calibration_state_done,
+	calibration_state_failed
+};
+
+/**
+ * @brief Steering calibration control.
+ *
+ * The producer stores a calibration_command_t into command, the plugin
+ * takes it at the start of the next frame and resets it to none.
+ */
+struct alignas(cacheLineSize) calibration_t
+{
+	// Written by the producer.
+	std::atomic<scs_u32_t> command;
+
+	// Written by the plugin.
+	alignas(cacheLineSize) std::atomic<scs_u32_t> state;		// calibration_state_t
+	std::atomic<scs_u32_t> samples;
+	std::atomic<scs_u32_t> filled_cells;	// (speed, input) cells with enough samples
+};
+
+enum macro_opcode_t
+{
+	macro_opcode_end,
+	macro_opcode_press,		// input
+	macro_opcode_release,		// input
+	macro_opcode_hold,		// input, argument = milliseconds
+	macro_opcode_wait_frames,	// argument = frames
+	macro_opcode_wait_ms		// argument = milliseconds
+};
+
+struct macro_instruction_t
+{
+	scs_u8_t opcode;		// macro_opcode_t
+	scs_u8_t input;			// index of a button input, numbered like the inputs
+	scs_u16_t argument;
+};
+
+const int macroMaxInstructions = 16;
+const int macroQueueLength = 16;
+
+// One line pair per entry, so neighbouring entries being filled and executed do not collide.
+struct alignas(cacheLineSize) macro_entry_t
+{
+	std::atomic<scs_u32_t> sequence;
+	scs_u32_t instruction_count;
+	macro_instruction_t instructions[macroMaxInstructions];
+};
+
+/**
+ * @brief Queue of button macros executed by the plugin.
+ *
+ * A bounded queue any number of producers can submit to: read tail, check
+ * that entries[tail % macroQueueLength].sequence equals tail (otherwise the
+ * queue is full or another producer was faster), claim the entry by swapping
+ * tail to tail + 1, fill it and store tail + 1 into its sequence. The plugin
+ * sets the sequence of every entry to its index when it creates the block.
+ */
+struct alignas(cacheLineSize) macro_queue_t
+{
+	std::atomic<scs_u32_t> tail;		// producers
+	alignas(cacheLineSize) std::atomic<scs_u32_t> head;	// plugin
+	std::atomic<scs_u32_t> executed;	// plugin, macros finished so far
+	std::atomic<scs_u32_t> running;		// plugin
+	macro_entry_t entries[macroQueueLength];
+};
+
+enum activity_flag_t
+{
+	activity_device_active = 1,	// the game is polling the device
+	activity_game_running = 2	// the simulation is not paused
+};
+
+/**
+ * @brief Activity of the game and the device published by the plugin.
+ *
+ * Every change increments changes and signals the activity event, so idle
+ * producers can block on it instead of polling. While either flag is clear
+ * the plugin skips the controllers, the rules and the calibration.
+ */
+struct alignas(cacheLineSize) activity_t
+{
+	std::atomic<scs_u32_t> state;		// activity_flag_t bits
+	std::atomic<scs_u32_t> changes;
+};
+
+// Plain copy of the telemetry, see telemetry_snapshot_t.
+struct telemetry_values_t
+{
+	scs_u64_t simulation_time;		// microseconds
+	scs_u32_t frames;			// telemetry frames so far
+	scs_u32_t game_time;			// minutes
+	scs_u32_t paused;
+	scs_s32_t gear;
+	float speed;				// m/s
+	float input_steering;
+	float input_throttle;
+	float input_brake;
+	float input_clutch;
+	float effective_steering;
+	float effective_throttle;
+	float effective_brake;
+	float effective_clutch;
+	float rpm;
+	float angular_velocity[3];		// rotations per second, vehicle space
+	float heading;				// world orientation, 0 - 1
+	float pitch;
+	float roll;
+	double position[3];			// world position in meters
+};
+
+/**
+ * @brief Telemetry published by the plugin at the end of every telemetry frame.
+ *
+ * Written between making sequence odd and even again, readers retry while
+ * it is odd or changed during their copy. Stays zero while the telemetry
+ * part of the plugin is not loaded.
+ */
+struct alignas(cacheLineSize) telemetry_snapshot_t
+{
+	std::atomic<scs_u32_t> sequence;
+	scs_u32_t _padding;
+	telemetry_values_t values;
+};
+
+const int statsHistogramBuckets = 16;
+
+enum memory_flag_t
+{
+	memory_flag_prefaulted = 1,		// the regions were pre-faulted at init
+	memory_flag_locked = 2,			// and locked in memory
+	memory_flag_lock_failed = 4,		// locking was asked for but refused by the system
+	memory_flag_large_pages = 8		// the recording ring got large pages
+};
+
+/**
+ * @brief Counters of the frame processing, written by the plugin.
+ *
+ * Histogram bucket i counts frames whose processing took [2^i - 1,
+ * 2^(i+1) - 1) us, not counting a lockstep wait. The memory fields describe
+ * the preparation of the regions the callbacks touch, see [memory] in the
+ * configuration, and the page faults taken while processing frames anyway.
+ */
+struct alignas(cacheLineSize) stats_t
+{
+	std::atomic<scs_u32_t> frames;
+	std::atomic<scs_u32_t> torn_reads;		// slot copies abandoned because the producer kept writing
+	std::atomic<scs_u32_t> stale_frames;		// frames without a commit since the previous frame
+	std::atomic<scs_u32_t> failsafe_frames;		// frames with all inputs released by the fail-safe
+	std::atomic<scs_u32_t> processing_histogram[statsHistogramBuckets];
+	std::atomic<scs_u32_t> memory_flags;		// memory_flag_t
+	std::atomic<scs_u32_t> prepared_pages;		// pages pre-faulted at init
+	std::atomic<scs_u32_t> prepare_time;		// microseconds spent pre-faulting and locking
+	std::atomic<scs_u32_t> page_faults;		// taken by the game thread while processing frames
+	std::atomic<scs_u32_t> faulting_frames;		// frames with at least one of them
+};
+
+/**
+ * @brief Counters of tools/scsbridge, which forwards frames received over a
+ * socket into producer slots.
+ *
+ * Written only by the bridge. Latencies are measured from the arrival of a
+ * datagram to the commit of the batch containing it, in microseconds.
+ */
+struct alignas(cacheLineSize) bridge_stats_t
+{
+	std::atomic<scs_u32_t> pid;			// process id of the running bridge, 0 = none
+	std::atomic<scs_u32_t> datagrams;
+	std::atomic<scs_u32_t> dropped;			// malformed, out of order or without a free slot
+	std::atomic<scs_u32_t> batches;			// datagrams read at once and committed together
+	std::atomic<scs_u32_t> commits;
+	std::atomic<scs_u32_t> p50_latency;		// over the last second
+	std::atomic<scs_u32_t> p99_latency;
+	std::atomic<scs_u32_t> latency_histogram[statsHistogramBuckets];
+};
+
+// Together SCS_INPUT_MAX_INPUT_COUNT, the most one device can have.
+const int genericAxisCount = 16;
+const int genericButtonCount = 384;
+
+/**
+ * @brief Inputs of the generic device, which the player binds in the game UI.
+ *
+ * Written by the producer like the block at offset 0 and released by the
+ * same fail-safe. The [generic] configuration section decides how many of
+ * them the device has.
+ */
+struct alignas(cacheLineSize) generic_inputs_t
+{
+	float axes[genericAxisCount];
+	bool buttons[genericButtonCount];
+};
+
+const scs_u32_t layoutMagic = 0x43534353;	// "SCSC"
+const scs_u32_t layoutVersion = 3;
+
+/**
+ * @brief Identifies the layout of the block for producers.
+ *
+ * Written by the plugin after it cleared the block, magic last. Producers
+ * compiled against this header compare version and schema with their own
+ * layoutVersion and layout_schema() before using anything past offset 64.
+ */
+struct alignas(cacheLineSize) layout_info_t
+{
+	std::atomic<scs_u32_t> magic;
+	scs_u32_t version;
+	scs_u32_t size;				// sizeof(control_block_t)
+	scs_u32_t schema;			// layout_schema() of the plugin
+};
+
+struct control_block_t
+{
+	// Written by the producers, the legacy layout.
+	float axes[axisCount];
+	bool buttons[buttonCount];
+	char _reserved0[2];
+	std::atomic<scs_u32_t> heartbeat;	// incremented by the producer, see the fail-safe timeout
+	scs_u8_t groups[input_group_count];	// 0 = use the buttons, n = only member n - 1 pressed
+	char _reserved1[1];
+	frame_sync_t sync;
+	trajectory_t trajectory;
+	controller_t controller;
+	producer_slot_t producers[producerSlotCount];
+	override_t human_override;
+	calibration_t calibration;
+	macro_queue_t macros;
+	activity_t activity;
+	layout_info_t layout;
+	telemetry_snapshot_t telemetry;
+	stats_t stats;
+	bridge_stats_t bridge;
+	generic_inputs_t generic;
+};
+
+static_assert(sizeof(std::atomic<scs_u32_t>) == sizeof(scs_u32_t), "counters are used as futexes");
+static_assert(button_flasher4way + 1 == buttonCount, "button names out of date");
+static_assert(offsetof(control_block_t, buttons) == axisSize, "legacy layout changed");
+static_assert(offsetof(control_block_t, heartbeat) == 56, "heartbeat moved");
+static_assert(offsetof(control_block_t, groups) == 60, "groups moved");
+static_assert(offsetof(control_block_t, sync) == 64, "legacy layout changed");
+static_assert(offsetof(frame_sync_t, lockstep) == cacheLineSize, "sync layout changed");
+static_assert(offsetof(frame_sync_t, lockstep_waits) == 2 * cacheLineSize, "sync layout changed");
+static_assert(sizeof(trajectory_knot_t) == 24, "knot layout changed");
+static_assert(offsetof(control_block_t, trajectory) == 320, "trajectory moved");
+static_assert(offsetof(trajectory_t, buffers) == 16, "trajectory layout changed");
+static_assert(offsetof(trajectory_t, samples) == 1600, "trajectory layout changed");
+static_assert(offsetof(control_block_t, controller) == 1984, "controller moved");
+static_assert(offsetof(controller_t, steering) == 2 * cacheLineSize, "controller layout changed");
+static_assert(sizeof(controller_t) == 256, "controller layout changed");
+static_assert(inputCount <= 64, "ownership masks have one bit per input");
+static_assert(offsetof(control_block_t, producers) == 2240, "producers moved");
+static_assert(offsetof(producer_slot_t, ownership) == 16, "producer layout changed");
+static_assert(offsetof(producer_slot_t, granted) == 2 * cacheLineSize, "producer layout changed");
+static_assert(sizeof(producer_slot_t) == 3 * cacheLineSize, "producer layout changed");
+static_assert(offsetof(control_block_t, human_override) == 3776, "override moved");
+static_assert(sizeof(override_t) == cacheLineSize, "override layout changed");
+static_assert(offsetof(control_block_t, calibration) == 3840, "calibration moved");
+static_assert(offsetof(calibration_t, state) == cacheLineSize, "calibration layout changed");
+static_assert(sizeof(macro_instruction_t) == 4, "macro layout changed");
+static_assert(sizeof(macro_entry_t) == 2 * cacheLineSize, "macro layout changed");
+static_assert(offsetof(control_block_t, macros) == 3968, "macros moved");
+static_assert(offsetof(macro_queue_t, head) == cacheLineSize, "macro layout changed");
+static_assert(offsetof(macro_queue_t, entries) == 2 * cacheLineSize, "macro layout changed");
+static_assert(offsetof(control_block_t, activity) == 6144, "activity moved");
+static_assert(offsetof(control_block_t, layout) == 6208, "layout info moved");
+static_assert(sizeof(telemetry_values_t) == 112, "telemetry layout changed");
+static_assert(offsetof(control_block_t, telemetry) == 6272, "telemetry moved");
+static_assert(offsetof(control_block_t, stats) == 6400, "stats moved");
+static_assert(offsetof(stats_t, memory_flags) == 80 && sizeof(stats_t) == 2 * cacheLineSize, "stats layout changed");
+static_assert(offsetof(control_block_t, bridge) == 6528, "bridge moved");
+static_assert(offsetof(control_block_t, generic) == 6656, "generic inputs moved");
+static_assert(offsetof(generic_inputs_t, buttons) == cacheLineSize, "generic layout changed");
+static_assert(sizeof(control_block_t) == 7104, "control block size changed");
+
+const size_t memsize = sizeof(control_block_t);
+
+// count runs of size bytes, stride bytes apart, starting at offset.
+struct block_range_t
+{
+	size_t offset;
+	size_t size;
+	size_t count;
+	size_t stride;
+};
+
+// Everything the producers write, the fields marked "Written by the
+// producer" above. The rest of the block belongs to the plugin and the
+// bridge, input_capture records and fake_host replays only these ranges.
+const block_range_t producerRanges[] = {
+	{ 0, offsetof(control_block_t, sync), 1, 0 },
+	{ offsetof(control_block_t, sync) + offsetof(frame_sync_t, lockstep), offsetof(frame_sync_t, lockstep_waits) - offsetof(frame_sync_t, lockstep), 1, 0 },
+	{ offsetof(control_block_t, trajectory), offsetof(trajectory_t, samples), 1, 0 },
+	{ offsetof(control_block_t, controller), offsetof(controller_t, steering), 1, 0 },
+	{ offsetof(control_block_t, producers), offsetof(producer_slot_t, granted), producerSlotCount, sizeof(producer_slot_t) },
+	{ offsetof(control_block_t, calibration), offsetof(calibration_t, state), 1, 0 },
+	{ offsetof(control_block_t, macros), offsetof(macro_queue_t, head), 1, 0 },
+	{ offsetof(control_block_t, macros) + offsetof(macro_queue_t, entries), sizeof(macro_entry_t) * macroQueueLength, 1, 0 },
+	{ offsetof(control_block_t, generic), sizeof(generic_inputs_t), 1, 0 }
+};
+const int producerRangeCount = sizeof(producerRanges) / sizeof(producerRanges[0]);
+
+// Bytes of all producer ranges packed one after the other.
+inline size_t producer_ranges_size(void)
+{
+	size_t size = 0;
+	for (int i = 0; i < producerRangeCount; i++)
+	{
+		size += producerRanges[i].size * producerRanges[i].count;
+	}
+	return size;
+}
+
+// FNV-1a over the counts and offsets producers depend on.
+constexpr scs_u32_t layout_schema(void)
+{
+	const scs_u64_t fields[] = {
+		axisCount, buttonCount, input_group_count, trajectoryKnotCount, producerSlotCount, cacheLineSize,
+		macroMaxInstructions, macroQueueLength, genericAxisCount, genericButtonCount,
+		offsetof(control_block_t, heartbeat), offsetof(control_block_t, groups),
+		offsetof(control_block_t, sync), offsetof(control_block_t, trajectory),
+		offsetof(control_block_t, controller), offsetof(control_block_t, producers),
+		offsetof(control_block_t, human_override), offsetof(control_block_t, calibration),
+		offsetof(control_block_t, macros), offsetof(control_block_t, activity),
+		offsetof(control_block_t, telemetry), sizeof(telemetry_values_t),
+		offsetof(control_block_t, stats), sizeof(stats_t),
+		offsetof(control_block_t, bridge), sizeof(bridge_stats_t),
+		offsetof(control_block_t, generic),
+		sizeof(frame_sync_t), sizeof(trajectory_t), sizeof(controller_t), sizeof(producer_slot_t),
+		sizeof(macro_entry_t), sizeof(control_block_t)
+	};
+	scs_u32_t hash = 2166136261u;
+	for (const scs_u64_t field : fields)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			hash = (hash ^ static_cast<scs_u32_t>((field >> (i * 8)) & 0xff)) * 16777619u;
+		}
+	}
+	return hash;
+}
+
+const int registryEntryCount = 16;
+const int registryGameIdSize = 16;
+const int registryNameSize = 88;
+
+/**
+ * @brief One plugin instance in the discovery registry.
+ *
+ * The plugin claims a free entry by swapping its process id into pid and
+ * fills in the rest between two increments of sequence, readers retry while
+ * sequence is odd or changed during their copy. Entries of processes which
+ * died without unregistering are reclaimed by the next instance.
+ */
+struct registry_entry_t
+{
+	std::atomic<scs_u32_t> pid;		// 0 = free
+	std::atomic<scs_u32_t> sequence;
+	scs_u32_t game_version;			// SCS_INPUT_INIT_PARAMS common.game_version
+	scs_u32_t _reserved;
+	scs_u64_t start_time;			// monotonic_time_us of the registration
+	char game_id[registryGameIdSize];	// SCS_GAME_ID_*
+	char name[registryNameSize];		// memory name of the control block
+};
+
+// Separate mapping named registryName, never removed once created.
+struct registry_t
+{
+	std::atomic<scs_u32_t> changes;		// incremented on every registration and removal
+	scs_u32_t _reserved;
+	registry_entry_t entries[registryEntryCount];
+};
+
+static_assert(sizeof(registry_entry_t) == 128, "registry layout changed");
+static_assert(offsetof(registry_t, entries) == 8, "registry layout changed");
+
+#endif // INPUT_SEMANTICAL_CONTROL_LAYOUT_H
@@ -0,0 +1,118 @@
+#include <math.h>
+#include <string.h>
+
+#include "controller.h"
+
+// Below this speed the curvature is not observable from the yaw rate and the
+// steering controller runs on its feedforward only.
+const float controllerMinimumSpeed = 1.0f;
+
+// Longer gaps between frames (loading, debugger) restart the controllers.
+const scs_u64_t controllerMaximumStep = 200000;
+
+const float controllerPi = 3.14159265358979f;
+
+// History of one controller not visible to the producer.
+struct pid_memory_t
+{
+	bool primed;
+	float previous_measured;
+	float previous_output;
+};
+
+static pid_memory_t steeringMemory;
+static pid_memory_t speedMemory;
+static scs_u64_t previousTime = 0;
+
+static float clamp(const float value, const float minimum, const float maximum)
+{
+	return value < minimum ? minimum : (value > maximum ? maximum : value);
+}
+
+static void pid_restart(pid_state_t& state, pid_memory_t& memory)
+{
+	memset(&state, 0, sizeof(state));
+	memset(&memory, 0, sizeof(memory));
+}
+
+static float pid_update(const pid_gains_t& gains, pid_state_t& state, pid_memory_t& memory, const float target, const float measured, const float dt)
+{
+	const float minimum = gains.output_min < gains.output_max ? gains.output_min : gains.output_max;
+	const float maximum = gains.output_min < gains.output_max ? gains.output_max : gains.output_min;
+
+	state.target = target;
+	state.measured = measured;
+	state.error = target - measured;
+	state.p = gains.kp * state.error;
+	state.feedforward = gains.feedforward * target;
+
+	// Derivative on the measurement so that target steps do not kick.
+	state.d = memory.primed ? -gains.kd * (measured - memory.previous_measured) / dt : 0.0f;
+
+	// Integrate only while that does not push a saturated output further.
+	const float step = gains.ki * state.error * dt;
+	const float unlimited = state.p + state.i + state.d + state.feedforward;
+	if (!((unlimited >= maximum && step > 0.0f) || (unlimited <= minimum && step < 0.0f))) {
+		state.i = clamp(state.i + step, -fabsf(gains.integral_limit), fabsf(gains.integral_limit));
+	}
+
+	float output = clamp(state.p + state.i + state.d + state.feedforward, minimum, maximum);
+	if (memory.primed && gains.rate_limit > 0.0f) {
+		const float change = gains.rate_limit * dt;
+		output = clamp(output, memory.previous_output - change, memory.previous_output + change);
+	}
+
+	state.output = output;
+	memory.primed = true;
+	memory.previous_measured = measured;
+	memory.previous_output = output;
+	return output;
+}
+
+void controller_update(controller_t& controller, const telemetry_state_t& state, const scs_u64_t time, float* const axes)
+{
+	const bool steeringEnabled = controller.steering_enabled.load(std::memory_order_acquire) != 0;
+	const bool speedEnabled = controller.speed_enabled.load(std::memory_order_acquire) != 0;
+
+	const bool restart = state.paused || previousTime == 0 || time <= previousTime || time - previousTime > controllerMaximumStep;
+	const float dt = restart ? 0.0f : static_cast<float>(time - previousTime) * 1e-6f;
+	previousTime = time;
+
+	if (!steeringEnabled || restart) {
+		pid_restart(controller.steering, steeringMemory);
+	}
+	if (!speedEnabled || restart) {
+		pid_restart(controller.speed, speedMemory);
+	}
+	if (state.paused || (!steeringEnabled && !speedEnabled)) {
+		return;
+	}
+
+	if (steeringEnabled) {
+		const float target = controller.target_curvature;
+
+		// Yaw rate in radians per second over the signed speed, which also
+		// keeps the sign right when reversing.
+		const float yawRate = state.angular_velocity.y * 2.0f * controllerPi;
+		const float measured = fabsf(state.speed) >= controllerMinimumSpeed ? yawRate / state.speed : target;
+
+		if (dt > 0.0f) {
+			axes[axis_steering] = pid_update(controller.steering_gains, controller.steering, steeringMemory, target, measured, dt);
+		}
+	}
+
+	if (speedEnabled && dt > 0.0f) {
+		const float output = pid_update(controller.speed_gains, controller.speed, speedMemory, controller.target_speed, state.speed, dt);
+		axes[axis_aforward] = output > 0.0f ? output : 0.0f;
+		axes[axis_abackward] = output < 0.0f ? -output : 0.0f;
+	}
+
+	controller.updates.fetch_add(1, std::memory_order_relaxed);
+}
+
+void controller_reset(void)
+{
+	memset(&steeringMemory, 0, sizeof(steeringMemory));
+	memset(&speedMemory, 0, sizeof(speedMemory));
+	previousTime = 0;
+}
@@ -0,0 +1,19 @@
+#ifndef INPUT_SEMANTICAL_CONTROLLER_H
+#define INPUT_SEMANTICAL_CONTROLLER_H
+
+#include "control_layout.h"
+#include "telemetry.h"
+
+/**
+ * @brief Runs the enabled steering and speed controllers for one frame.
+ *
+ * Overwrites the steering, aforward and abackward values of the enabled
+ * controllers and publishes their internals. While the simulation is paused
+ * the controllers are reset and leave the values alone.
+ */
+void controller_update(controller_t& controller, const telemetry_state_t& state, const scs_u64_t time, float* const axes);
+
+// Forgets the controller history, e.g. when the control block is recreated.
+void controller_reset(void);
+
+#endif // INPUT_SEMANTICAL_CONTROLLER_H
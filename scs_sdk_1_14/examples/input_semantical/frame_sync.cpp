@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_sync.h"
+#include "log.h"
+#include "platform.h"
+#include "stats.h"
+
+static shared_event_t frameEvent;
+static shared_event_t ackEvent;
+static frame_clock_t frameClock = NULL;
+
+SCSAPI_VOID input_semantical_set_clock(const frame_clock_t clock)
+{
+	frameClock = clock;
+}
+
+bool frame_sync_open(const char* const name)
+{
+	char event_name[256];
+
+	snprintf(event_name, sizeof(event_name), "%s%s", name, frameEventSuffix);
+	if (!shared_event_create(frameEvent, event_name)) {
+		log_line("Failed to create event %s.", event_name);
+		return false;
+	}
+
+	snprintf(event_name, sizeof(event_name), "%s%s", name, ackEventSuffix);
+	if (!shared_event_create(ackEvent, event_name)) {
+		log_line("Failed to create event %s.", event_name);
+		shared_event_close(frameEvent);
+		return false;
+	}
+	return true;
+}
+
+void frame_sync_close(void)
+{
+	shared_event_close(frameEvent);
+	shared_event_close(ackEvent);
+}
+
+void frame_sync_begin_frame(frame_sync_t& sync)
+{
+	const scs_u64_t start = monotonic_time_us();
+	const scs_u32_t frame = sync.frame.load(std::memory_order_relaxed) + 1;
+
+	sync.frame_time.store(frameClock ? frameClock() : start, std::memory_order_relaxed);
+	sync.frame.store(frame, std::memory_order_release);
+	shared_event_signal(frameEvent, sync.frame);
+
+	if (!sync.lockstep.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	const scs_u32_t configured_timeout = sync.lockstep_timeout.load(std::memory_order_relaxed);
+	const scs_u64_t timeout = configured_timeout ? configured_timeout : defaultLockstepTimeout;
+	const scs_u64_t deadline = start + timeout;
+
+	// Spin briefly as a producer running ahead acks almost immediately, then
+	// block in short slices so a producer which never signals the event is
+	// still noticed quickly.
+	scs_u64_t now = start;
+	scs_u32_t acked = sync.ack_frame.load(std::memory_order_acquire);
+	while (acked != frame && now < start + defaultLockstepSpin)
+	{
+		now = monotonic_time_us();
+		acked = sync.ack_frame.load(std::memory_order_acquire);
+	}
+	while (acked != frame && now < deadline)
+	{
+		const scs_u64_t remaining = deadline - now;
+		shared_event_wait(ackEvent, sync.ack_frame, acked, remaining < 1000 ? remaining : 1000);
+		now = monotonic_time_us();
+		acked = sync.ack_frame.load(std::memory_order_acquire);
+	}
+
+	sync.lockstep_waits.fetch_add(1, std::memory_order_relaxed);
+	sync.wait_histogram[stats_bucket(now - start, lockstepHistogramBuckets)].fetch_add(1, std::memory_order_relaxed);
+	if (acked != frame) {
+		sync.lockstep_misses.fetch_add(1, std::memory_order_relaxed);
+	}
+}
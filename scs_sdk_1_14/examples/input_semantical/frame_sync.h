@@ -0,0 +1,31 @@
+#ifndef INPUT_SEMANTICAL_FRAME_SYNC_H
+#define INPUT_SEMANTICAL_FRAME_SYNC_H
+
+#include "control_layout.h"
+
+// Source of the frame time, monotonic_time_us() unless a host installs
+// its own clock through input_semantical_set_clock.
+typedef scs_u64_t (SCSAPIFUNC *frame_clock_t)(void);
+
+// Creates the events which accompany the frame and ack counters.
+bool frame_sync_open(const char* const name);
+void frame_sync_close(void);
+
+/**
+ * @brief Publishes the next frame and in lockstep mode waits for its command.
+ *
+ * Called on the game thread at the first input event callback of a frame.
+ */
+void frame_sync_begin_frame(frame_sync_t& sync);
+
+/**
+ * @brief Replaces the clock behind frame_sync_t::frame_time.
+ *
+ * Everything timed per frame (fail-safe, producer timeouts, trajectory,
+ * macros, override) derives from frame_time, so a host replaying a capture
+ * on a virtual clock gets the same frames regardless of its pacing. NULL
+ * restores monotonic_time_us(). The lockstep wait stays on the real clock.
+ */
+extern "C" SCSAPI_VOID input_semantical_set_clock(const frame_clock_t clock);
+
+#endif // INPUT_SEMANTICAL_FRAME_SYNC_H
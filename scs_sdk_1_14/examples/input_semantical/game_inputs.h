@@ -0,0 +1,91 @@
+/**
+ * @brief Mixes supported by each game, fixed at compile time.
+ *
+ * Every game has a traits struct with the range of input API game versions
+ * it was written against and the game version which introduced each slot of
+ * the control block (0 = the game has no such mix). The plugin registers only
+ * the mixes known to the running game version and instantiates the frame
+ * processing per game, so the per-frame code never checks the game.
+ */
+#ifndef INPUT_SEMANTICAL_GAME_INPUTS_H
+#define INPUT_SEMANTICAL_GAME_INPUTS_H
+
+#include "control_layout.h"
+
+#include "scssdk_input.h"
+#include "eurotrucks2/scssdk_eut2.h"
+#include "eurotrucks2/scssdk_input_eut2.h"
+#include "amtrucks/scssdk_ats.h"
+#include "amtrucks/scssdk_input_ats.h"
+
+// One bit per slot of the control block.
+typedef scs_u64_t input_mask_t;
+
+static_assert(inputCount <= 64, "input masks have one bit per input");
+
+const scs_u32_t eut2_1_00 = SCS_INPUT_EUT2_GAME_VERSION_1_00;
+const scs_u32_t ats_1_00 = SCS_INPUT_ATS_GAME_VERSION_1_00;
+
+// Game version introducing each slot, in the order of the input table.
+constexpr scs_u32_t eut2InputVersions[inputCount] = {
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,				// steering - clutch
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,	// pause - cruiectrlres
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,			// light - quickpark
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,			// drive - wipersback
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,			// wipers0 - wipers4
+	eut2_1_00, eut2_1_00, eut2_1_00,					// horn - lighthorn
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,				// cam1 - cam4
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00,				// cam5 - cam8
+	eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00, eut2_1_00	// mapzoom_in - flasher4way
+};
+
+constexpr scs_u32_t atsInputVersions[inputCount] = {
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00,
+	ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00, ats_1_00
+};
+
+struct game_eut2_t
+{
+	static constexpr const char* name() { return SCS_GAME_ID_EUT2; }
+	static constexpr scs_u32_t minimum_version = SCS_INPUT_EUT2_GAME_VERSION_1_00;
+	static constexpr scs_u32_t current_version = SCS_INPUT_EUT2_GAME_VERSION_CURRENT;
+	static constexpr scs_u32_t since(const int slot) { return eut2InputVersions[slot]; }
+};
+
+struct game_ats_t
+{
+	static constexpr const char* name() { return SCS_GAME_ID_ATS; }
+	static constexpr scs_u32_t minimum_version = SCS_INPUT_ATS_GAME_VERSION_1_00;
+	static constexpr scs_u32_t current_version = SCS_INPUT_ATS_GAME_VERSION_CURRENT;
+	static constexpr scs_u32_t since(const int slot) { return atsInputVersions[slot]; }
+};
+
+// Slots with a mix in the given game version.
+template <typename game_t>
+constexpr input_mask_t game_input_mask(const scs_u32_t version)
+{
+	input_mask_t mask = 0;
+	for (int i = 0; i < inputCount; i++)
+	{
+		if (game_t::since(i) != 0 && game_t::since(i) <= version) {
+			mask |= input_mask_t(1) << i;
+		}
+	}
+	return mask;
+}
+
+// Slots with a mix in any version of the game.
+template <typename game_t>
+constexpr input_mask_t game_input_all(void)
+{
+	return game_input_mask<game_t>(0xffffffffu);
+}
+
+#endif // INPUT_SEMANTICAL_GAME_INPUTS_H
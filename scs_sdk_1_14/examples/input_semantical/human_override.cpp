@@ -0,0 +1,126 @@
+#include <math.h>
+#include <string.h>
+
+#include "human_override.h"
+#include "log.h"
+
+// Longer gaps between frames (loading, debugger) do not advance the ramp.
+const scs_u64_t overrideMaximumStep = 200000;
+
+struct override_channel_state_t
+{
+	bool engaged;
+	scs_u64_t quiet_since;		// start of the deviation below the release threshold, 0 = not quiet
+	float authority;
+};
+
+static override_channel_state_t channels[override_channel_count];
+
+// Commands sent in the last two frames. The telemetry can lag one more frame
+// behind the input when no physics step ran in between.
+static float sent[2][axisCount];
+static scs_u64_t previousTime = 0;
+
+static float deviation(const float input, const int axis)
+{
+	const float last = input - sent[0][axis];
+	const float before = input - sent[1][axis];
+	return fabsf(last) < fabsf(before) ? last : before;
+}
+
+static void remember(const float* const axes)
+{
+	memcpy(sent[1], sent[0], sizeof(sent[0]));
+	for (int i = 0; i < axisCount; i++)
+	{
+		sent[0][i] = axes[i] > 1.0f ? 1.0f : (axes[i] < -1.0f ? -1.0f : axes[i]);
+	}
+}
+
+static void update_channel(override_t& published, const override_config_t& config, const int channel, const float threshold, const float deviation, const scs_u64_t time, const float dt)
+{
+	override_channel_state_t& state = channels[channel];
+	const float magnitude = fabsf(deviation);
+
+	if (!state.engaged && magnitude > threshold) {
+		state.engaged = true;
+		state.quiet_since = 0;
+		state.authority = config.authority < 0.0f ? 0.0f : (config.authority > 1.0f ? 1.0f : config.authority);
+		published.takeovers.fetch_add(1, std::memory_order_relaxed);
+		log_line("Driver took over %s.", channel == override_channel_steering ? "steering" : "pedals");
+	}
+	else if (state.engaged) {
+		if (magnitude >= config.release_threshold) {
+			state.quiet_since = 0;
+		}
+		else if (state.quiet_since == 0) {
+			state.quiet_since = time;
+		}
+		else if (time - state.quiet_since >= static_cast<scs_u64_t>(config.release_time) * 1000) {
+			state.engaged = false;
+			log_line("Driver released %s.", channel == override_channel_steering ? "steering" : "pedals");
+		}
+	}
+	else if (state.authority < 1.0f) {
+		state.authority = config.return_time == 0 ? 1.0f : state.authority + dt * 1000.0f / config.return_time;
+		if (state.authority > 1.0f) {
+			state.authority = 1.0f;
+		}
+	}
+
+	published.authority[channel] = state.authority;
+	published.deviation[channel] = deviation;
+}
+
+void human_override_update(override_t& published, const override_config_t& config, const telemetry_state_t& state, const scs_u64_t time, float* const axes)
+{
+	if (!config.enabled || !state.active || state.paused) {
+		human_override_reset();
+		published.active.store(0, std::memory_order_relaxed);
+		for (int i = 0; i < override_channel_count; i++)
+		{
+			published.authority[i] = 1.0f;
+			published.deviation[i] = 0.0f;
+		}
+		remember(axes);
+		return;
+	}
+
+	const bool step = previousTime != 0 && time > previousTime && time - previousTime <= overrideMaximumStep;
+	const float dt = step ? static_cast<float>(time - previousTime) * 1e-6f : 0.0f;
+	previousTime = time;
+
+	const float steering = deviation(state.input_steering * config.steering_sign, axis_steering);
+	const float throttle = deviation(state.input_throttle, axis_aforward);
+	const float brake = deviation(state.input_brake, axis_abackward);
+	const float pedals = fabsf(throttle) > fabsf(brake) ? throttle : brake;
+
+	update_channel(published, config, override_channel_steering, config.steering_threshold, steering, time, dt);
+	update_channel(published, config, override_channel_pedals, config.pedal_threshold, pedals, time, dt);
+
+	axes[axis_steering] *= channels[override_channel_steering].authority;
+	axes[axis_aforward] *= channels[override_channel_pedals].authority;
+	axes[axis_abackward] *= channels[override_channel_pedals].authority;
+
+	scs_u32_t active = 0;
+	for (int i = 0; i < override_channel_count; i++)
+	{
+		if (channels[i].engaged) {
+			active |= 1u << i;
+		}
+	}
+	published.active.store(active, std::memory_order_relaxed);
+
+	remember(axes);
+}
+
+void human_override_reset(void)
+{
+	for (int i = 0; i < override_channel_count; i++)
+	{
+		channels[i].engaged = false;
+		channels[i].quiet_since = 0;
+		channels[i].authority = 1.0f;
+	}
+	previousTime = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef INPUT_SEMANTICAL_HUMAN_OVERRIDE_H
+#define INPUT_SEMANTICAL_HUMAN_OVERRIDE_H
+
+#include "config.h"
+#include "control_layout.h"
+#include "telemetry.h"
+
+/**
+ * @brief Detects the driver taking over and scales the command down.
+ *
+ * Compares the telemetry input with the commands sent in the previous
+ * frames, scales the steering, aforward and abackward values by the current
+ * authority of their channel and publishes the state. Does nothing while
+ * the telemetry is not running, the game is paused or it is disabled.
+ */
+void human_override_update(override_t& published, const override_config_t& config, const telemetry_state_t& state, const scs_u64_t time, float* const axes);
+
+// Hands the control back and forgets the history.
+void human_override_reset(void);
+
+#endif // INPUT_SEMANTICAL_HUMAN_OVERRIDE_H
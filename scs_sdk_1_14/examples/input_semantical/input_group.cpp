@@ -0,0 +1,29 @@
+#include "input_group.h"
+
+void input_group_expand(const scs_u8_t* const groups, float* const slots)
+{
+	for (int group = 0; group < input_group_count; group++)
+	{
+		const input_group_range_t& range = inputGroupRanges[group];
+		const int selected = groups[group];
+		if (selected == 0 || selected > range.count) {
+			continue;
+		}
+		for (int member = 0; member < range.count; member++)
+		{
+			slots[range.first + member] = (member == selected - 1) ? 1.0f : 0.0f;
+		}
+	}
+}
+
+bool input_group_member(const int slot)
+{
+	for (int group = 0; group < input_group_count; group++)
+	{
+		const input_group_range_t& range = inputGroupRanges[group];
+		if (slot >= range.first && slot < range.first + range.count) {
+			return true;
+		}
+	}
+	return false;
+}
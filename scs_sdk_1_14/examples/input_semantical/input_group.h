@@ -0,0 +1,17 @@
+#ifndef INPUT_SEMANTICAL_INPUT_GROUP_H
+#define INPUT_SEMANTICAL_INPUT_GROUP_H
+
+#include "control_layout.h"
+
+/**
+ * @brief Expands the group values into one-hot button slots.
+ *
+ * Groups set to zero or to a value past their last member keep the button
+ * slots written by the producer.
+ */
+void input_group_expand(const scs_u8_t* const groups, float* const slots);
+
+// True when the slot is a member of any group.
+bool input_group_member(const int slot);
+
+#endif // INPUT_SEMANTICAL_INPUT_GROUP_H
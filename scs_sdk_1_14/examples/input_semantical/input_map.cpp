@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "input_map.h"
+
+const int inputMapWordSize = 64;
+
+static void entry_default(input_map_entry_t& entry, const int slot)
+{
+	entry.source = slot;
+	entry.scale = 1.0f;
+	entry.offset = 0.0f;
+	entry.minimum = slot < axisCount ? -1.0f : 0.0f;
+	entry.maximum = 1.0f;
+}
+
+void input_map_default(input_map_entry_t* const map)
+{
+	for (int i = 0; i < inputCount; i++)
+	{
+		entry_default(map[i], i);
+	}
+}
+
+// Copies the next space separated word, returns the rest of the text.
+static const char* next_word(const char* text, char* const word)
+{
+	while (*text == ' ' || *text == '\t') {
+		text++;
+	}
+	int length = 0;
+	while (*text && *text != ' ' && *text != '\t')
+	{
+		if (length < inputMapWordSize - 1) {
+			word[length++] = *text;
+		}
+		text++;
+	}
+	word[length] = '\0';
+	return text;
+}
+
+bool input_map_parse(input_map_entry_t& entry, const int target, const char* const value, const scs_input_device_input_t* const inputs)
+{
+	char word[inputMapWordSize];
+	const char* rest = next_word(value, word);
+
+	int source = -1;
+	for (int i = 0; i < inputCount; i++)
+	{
+		if (strcmp(inputs[i].name, word) == 0) {
+			source = i;
+			break;
+		}
+	}
+	if (source < 0) {
+		return false;
+	}
+
+	input_map_entry_t result;
+	entry_default(result, target);
+	result.source = source;
+
+	bool invert = false;
+	float scale = 1.0f;
+	int half = 0;
+	for (rest = next_word(rest, word); word[0]; rest = next_word(rest, word))
+	{
+		if (strcmp(word, "invert") == 0) {
+			invert = true;
+		}
+		else if (strcmp(word, "positive") == 0) {
+			half = 1;
+		}
+		else if (strcmp(word, "negative") == 0) {
+			half = -1;
+		}
+		else if (strncmp(word, "scale=", 6) == 0) {
+			char* end;
+			scale = static_cast<float>(strtod(word + 6, &end));
+			if (end == word + 6 || *end) {
+				return false;
+			}
+		}
+		else {
+			return false;
+		}
+	}
+
+	result.scale = scale;
+	if (invert) {
+		// Buttons flip between 0 and 1, axes change sign.
+		result.scale = -scale;
+		result.offset = source < axisCount ? 0.0f : 1.0f;
+	}
+	if (half != 0) {
+		result.scale *= static_cast<float>(half);
+		result.offset *= static_cast<float>(half);
+		result.minimum = 0.0f;
+	}
+
+	entry = result;
+	return true;
+}
+
+void input_map_gather(const input_map_entry_t* const map, const float* const slots, float* const axes, bool* const buttons)
+{
+	float values[inputCount];
+	for (int i = 0; i < inputCount; i++)
+	{
+		const input_map_entry_t& entry = map[i];
+		const float value = slots[entry.source] * entry.scale + entry.offset;
+		values[i] = value < entry.minimum ? entry.minimum : (value > entry.maximum ? entry.maximum : value);
+	}
+
+	for (int i = 0; i < axisCount; i++)
+	{
+		axes[i] = values[i];
+	}
+	for (int i = 0; i < buttonCount; i++)
+	{
+		buttons[i] = values[axisCount + i] > 0.5f;
+	}
+}
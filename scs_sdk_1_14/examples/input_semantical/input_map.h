@@ -0,0 +1,40 @@
+/**
+ * @brief Routing of the control block slots to the device inputs.
+ *
+ * Slots are numbered like the inputs: the axes first, then the buttons. Each
+ * input takes its value from one slot as clamp(slot * scale + offset,
+ * minimum, maximum), with buttons read as 0 or 1 and set when the result is
+ * above one half. This covers inversion, scaling and splitting one bipolar
+ * axis into aforward and abackward, and is evaluated as one gather per frame.
+ */
+#ifndef INPUT_SEMANTICAL_INPUT_MAP_H
+#define INPUT_SEMANTICAL_INPUT_MAP_H
+
+#include "control_layout.h"
+
+#include "scssdk_input.h"
+
+struct input_map_entry_t
+{
+	int source;		// slot index
+	float scale;
+	float offset;
+	float minimum;
+	float maximum;
+};
+
+// Every input reads its own slot.
+void input_map_default(input_map_entry_t* const map);
+
+/**
+ * @brief Parses the mapping of one input.
+ *
+ * The value is the name of the source slot followed by any of "invert",
+ * "scale=<factor>", "positive" or "negative", the last two keeping only that
+ * half of a bipolar axis as a positive value.
+ */
+bool input_map_parse(input_map_entry_t& entry, const int target, const char* const value, const scs_input_device_input_t* const inputs);
+
+void input_map_gather(const input_map_entry_t* const map, const float* const slots, float* const axes, bool* const buttons);
+
+#endif // INPUT_SEMANTICAL_INPUT_MAP_H
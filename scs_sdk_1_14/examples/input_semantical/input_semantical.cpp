@@ -18,202 +18,771 @@
 #include <stdarg.h>
 #include <string.h>
 #include <time.h>
-#include <array>
-#include <sstream>
-const time_t startTime = time(NULL);
 
-// Management of the log file.
-FILE* log_file = NULL;
+#include "control_layout.h"
+#include "activity.h"
+#include "arbitration.h"
+#include "config.h"
+#include "controller.h"
+#include "frame_sync.h"
+#include "game_inputs.h"
+#include "human_override.h"
+#include "input_group.h"
+#include "input_map.h"
+#include "instance_registry.h"
+#include "log.h"
+#include "macro.h"
+#include "platform.h"
+#include "response_curve.h"
+#include "rule_vm.h"
+#include "stats.h"
+#include "steering_calibration.h"
+#include "telemetry.h"
+#include "telemetry_recorder.h"
+#include "trajectory.h"
 
-bool init_log(void)
-{
-	if (log_file) {
-		return true;
+// SDK
+#include "scssdk_input.h"
+#include "eurotrucks2/scssdk_eut2.h"
+#include "eurotrucks2/scssdk_input_eut2.h"
+#include "amtrucks/scssdk_ats.h"
+#include "amtrucks/scssdk_input_ats.h"
+
+// Shared Memory
+shared_memory_t sharedMemory;
+control_block_t* controlBlock = NULL;
+
+// Game this instance runs in and the memory name derived from it.
+char gameId[registryGameIdSize] = "";
+scs_u32_t gameVersion = 0;
+char memoryName[configNameSize] = "";
+
+// Active configuration, replaced as a whole when the file changes. A reload
+// fills the other of the two buffers, so it does not allocate.
+config_t configs[2];
+config_t* config = NULL;
+scs_u32_t framesSinceReloadCheck = 0;
+
+// Outcome of prepare_memory, published into every block this instance opens.
+scs_u32_t memoryFlags = 0;
+scs_u32_t preparedPages = 0;
+scs_u32_t prepareTime = 0;
+bool memoryLocked = false;
+bool memoryPrepared = false;
+memory_config_t preparedMemory;		// [memory] as applied by prepare_memory
+
+void publish_memory_stats() {
+	stats_t& stats = controlBlock->stats;
+	stats.memory_flags.store(memoryFlags, std::memory_order_relaxed);
+	stats.prepared_pages.store(preparedPages, std::memory_order_relaxed);
+	stats.prepare_time.store(prepareTime, std::memory_order_relaxed);
+}
+
+// A block reopened by a reload gets the [memory] settings of the init
+// before it is cleared, so the published flags hold for it as well.
+void prepare_block() {
+	if (preparedMemory.prefault) {
+		memory_prefault(sharedMemory.data, memsize);
 	}
-	log_file = fopen("input.log", "wt");
-	fprintf(log_file, "Log opened\n");
-	if (!log_file) {
-		return false;
+	if (preparedMemory.lock && !memory_lock(sharedMemory.data, memsize)) {
+		memoryFlags = (memoryFlags & ~memory_flag_locked) | memory_flag_lock_failed;
+		log_error("Failed to lock the shared mem file %s in memory.", memoryName);
 	}
-	return true;
 }
 
-void finish_log(void)
-{
-	if (!log_file) {
+// Function to initialize shared memory
+void initialize_mem() {
+	instance_memory_name(memoryName, sizeof(memoryName), config->memory_name, config->memory_namespace, gameId, config->memory_suffix);
+	// Other instances and producers keep using a shared or per game name
+	// after this instance is gone, only a per process block is removed.
+	const bool opened = (config->memory_namespace == memory_namespace_instance) ?
+		shared_memory_create(sharedMemory, memoryName, memsize) : shared_memory_attach(sharedMemory, memoryName, memsize);
+	if (!opened) {
+		// On Windows a section keeps the size of whoever created it first.
+		const size_t existing = shared_memory_size(memoryName);
+		if (existing != 0 && existing < memsize) {
+			log_error("Shared mem file %s already exists with less than the %u bytes of layout version %u, probably created by a producer for the 64 byte layout. Close it and sdk reload, see readme.md.",
+				memoryName, static_cast<unsigned>(memsize), layoutVersion);
+		}
+		else {
+			log_error("Failed to create shared mem file %s.", memoryName);
+		}
 		return;
 	}
-	fprintf(log_file, "Log ended\n");
-	fclose(log_file);
-	log_file = NULL;
-}
 
-void log_print(const char* const text, ...)
-{
-	if (!log_file) {
-		return;
+	if (memoryPrepared) {
+		prepare_block();
 	}
-	va_list args;
-	va_start(args, text);
-	vfprintf(log_file, text, args);
-	va_end(args);
+	memset(sharedMemory.data, 0, memsize);
+	controlBlock = static_cast<control_block_t*>(sharedMemory.data);
+
+	frame_sync_open(memoryName);
+	activity_open(controlBlock->activity, memoryName);
+	telemetry_share(&controlBlock->telemetry);
+	instance_registry_add(memoryName, gameId, gameVersion);
+	trajectory_reset();
+	controller_reset();
+	arbitration_reset();
+	human_override_reset();
+	steering_calibration_reset();
+	macro_reset(controlBlock->macros);
+	publish_memory_stats();
+
+	// Last, producers waiting for the magic find everything else initialized.
+	controlBlock->layout.version = layoutVersion;
+	controlBlock->layout.size = static_cast<scs_u32_t>(memsize);
+	controlBlock->layout.schema = layout_schema();
+	controlBlock->layout.magic.store(layoutMagic, std::memory_order_release);
+
+	log_line("Successfully opened shared mem file %s.", memoryName);
 }
 
-void log_line(const char* const text, ...)
+// Regions the callbacks write to besides the recording ring.
+struct memory_region_t
 {
-	if (!log_file) {
-		return;
+	void* data;
+	size_t size;
+};
+
+int memory_regions(memory_region_t* const regions) {
+	int count = 0;
+	if (sharedMemory.data) {
+		regions[count].data = sharedMemory.data;
+		regions[count].size = memsize;
+		count++;
 	}
-	va_list args;
-	va_start(args, text);
-	vfprintf(log_file, text, args);
-
-	fprintf(log_file, "\n");
-	va_end(args);
+	regions[count].data = configs;
+	regions[count].size = sizeof(configs);
+	count++;
+	regions[count].data = config_file_buffer(regions[count].size);
+	count++;
+	return count;
 }
 
-// SDK
-#include "scssdk_input.h"
-#include "eurotrucks2/scssdk_eut2.h"
-#include "eurotrucks2/scssdk_input_eut2.h"
-#include "amtrucks/scssdk_ats.h"
-#include "amtrucks/scssdk_input_ats.h"
+// Faults in, and optionally locks, every page the callbacks write to, so
+// the game thread does not take the first-touch faults mid-drive.
+void prepare_memory() {
+	const memory_config_t& memory = config->memory;
+	const scs_u64_t start = monotonic_time_us();
+
+	memory_region_t regions[3];
+	const int regionCount = memory_regions(regions);
+	size_t pages = 0;
+	bool lockFailed = false;
+	for (int i = 0; i < regionCount; i++)
+	{
+		if (memory.prefault) {
+			pages += memory_prefault(regions[i].data, regions[i].size);
+		}
+		if (memory.lock && !memory_lock(regions[i].data, regions[i].size)) {
+			lockFailed = true;
+		}
+	}
+	memoryLocked = memory.lock;
+	memoryPrepared = true;
+	preparedMemory = memory;
+
+	recorder_memory_t recorder;
+	recorder_configure_memory(memory.prefault, memory.lock, memory.large_pages, recorder);
+	pages += recorder.pages;
+	lockFailed = lockFailed || recorder.lock_failed;
+
+	preparedPages = static_cast<scs_u32_t>(pages);
+	prepareTime = static_cast<scs_u32_t>(monotonic_time_us() - start);
+	memoryFlags = (memory.prefault ? memory_flag_prefaulted : 0) | (memory.lock && !lockFailed ? memory_flag_locked : 0) |
+		(lockFailed ? memory_flag_lock_failed : 0) | (recorder.large ? memory_flag_large_pages : 0);
+	if (controlBlock) {
+		publish_memory_stats();
+	}
 
-// Shared Memory
-const int axisCount = 4;
-const int buttonCount = 38;
-const wchar_t* memname = L"Local\\SCSControls";
-const size_t buttonSize = buttonCount * sizeof(bool);
-const size_t axisSize = axisCount * sizeof(float);
-const size_t size = axisSize + buttonSize;
-HANDLE hMapFile;
+	if (lockFailed) {
+		log_error("Failed to lock all pages in memory, raise the locked memory limit.");
+	}
+	log_line("Prepared %u pages in %u us.", preparedPages, prepareTime);
+}
 
-// Function to initialize shared memory
-void initialize_mem() {
-	hMapFile = CreateFileMapping(
-		INVALID_HANDLE_VALUE,    // use paging file
-		NULL,                    // default security
-		PAGE_READWRITE,          // read/write access
-		0,                       // maximum object size (high-order DWORD)
-		size,                    // maximum object size (low-order DWORD)
-		memname);                // name of mapping object
-
-	if (hMapFile == NULL) {
-		DWORD dw = GetLastError();
-		std::stringstream ss;
-		ss << dw;
-		std::string message = "Failed to create file mapping. Error code: " + ss.str();
-		log_line(message.c_str());
+void release_memory() {
+	memoryPrepared = false;
+	if (!memoryLocked) {
 		return;
 	}
+	memory_region_t regions[3];
+	const int regionCount = memory_regions(regions);
+	for (int i = 0; i < regionCount; i++)
+	{
+		memory_unlock(regions[i].data, regions[i].size);
+	}
+	memoryLocked = false;
+}
 
-	void* pBuf = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
-
-	if (pBuf == NULL) {
-		log_line("Failed to map view of file.");
-		CloseHandle(hMapFile);
-		hMapFile = NULL;
+// Copies the shared axes and buttons into the first inputCount slots.
+void read_mem(float* const slots) {
+	if (controlBlock == NULL) {
+		log_line("Shared mem file not open.");
+		memset(slots, 0, inputCount * sizeof(float));
 		return;
 	}
 
-	float data[buttonCount + axisCount] = {};
-	for (int i = 0; i < buttonCount + axisCount; i++)
+	memcpy(slots, controlBlock->axes, axisSize);
+	for (int i = 0; i < buttonCount; i++)
 	{
-		if (i < axisCount)
-		{
-			data[i] = 0.0;
-		}
-		else
-		{
-			data[i] = false;
-		}
+		slots[axisCount + i] = controlBlock->buttons[i] ? 1.0f : 0.0f;
 	}
-	memcpy(pBuf, data, size);
+}
 
-	UnmapViewOfFile(pBuf);
+// These are all the somewhat useful commands from the controls. The name of
+// the input matches the name of the mix as seen in controls.sii. Note that only
+// some inputs are supported this way. See documentation of
+// SCS_INPUT_DEVICE_TYPE_semantical
+// Name, Index, Type, Control Name In File
+// Steering, 0, float, steering
+// Acceleration, 1, float, aforward
+// Braking, 2, float, abackward
+// Clutch, 3, float, clutch
+// Pause Game, 4, bool,
+// Parking Brake, 5, bool, parkingbrake
+// Wipers, 6, bool, wipers
+// Cruise Control, 7, bool, cruiectrl
+// Cruise Control Increase, 8, bool, cruiectrlinc
+// Cruise Control Decrease, 9, bool, cruiectrldec
+// Cruise Control Reset, 10, bool, cruiectrlres
+// Lights, 11, bool, light
+// High Beams, 12, bool, hblight
+// Left Blinker, 13, bool, lblinker
+// Right Blinker, 14, bool, rblinker
+// Quickpark, 15, bool, quickpark
+// Drive(Gear), 16, bool, drive
+// Reverse(Gear), 17, bool, reverse
+// Cycle Zoom(map ? ), 18, bool, cycl_zoom
+// Reset Trip, 19, bool, tripreset
+// Rear Wipers, 20, bool, wipersback
+// Wiper LVL 0, 21, bool, wipers0
+// Wiper LVL 1, 22, bool, wipers1
+// Wiper LVL 2, 23, bool, wipers2
+// Wiper LVL 3, 24, bool, wipers3
+// Wiper LVL 4, 25, bool, wipers4
+// Horn, 26, bool, horn
+// Airhorn, 27, bool, airhorn
+// Light Horn, 28, bool, lighthorn
+// Camera 1, 29, bool, cam1
+// Camera 2, 30, bool, cam2
+// Camera 3, 31, bool, cam3
+// Camera 4, 32, bool, cam4
+// Camera 5, 33, bool, cam5
+// Camera 6, 34, bool, cam6
+// Camera 7, 35, bool, cam7
+// Camera 8, 36, bool, cam8
+// Zoom Map In, 37, bool, mapzoom_in
+// Zoom Map Out, 38, bool, mapzoom_out
+// ACC Mode, 39, bool, accmode
+// Show Mirrors, 40, bool, showmirrors
+// Hazard Lights, 41, bool, flasher4way
+
+const scs_input_device_input_t deviceInputs[inputCount] = {
+	{"steering", "ETS2LA Steering", SCS_VALUE_TYPE_float }, 
+	{"aforward", "ETS2LA Forward", SCS_VALUE_TYPE_float }, 
+	{"abackward", "ETS2LA Backward", SCS_VALUE_TYPE_float },
+	{"clutch", "ETS2LA Clutch", SCS_VALUE_TYPE_float },
+	{"pause", "ETS2LA Pause", SCS_VALUE_TYPE_bool },
+	{"parkingbrake", "ETS2LA Parking Brake", SCS_VALUE_TYPE_bool },
+	{"wipers", "ETS2LA Wipers", SCS_VALUE_TYPE_bool },
+	{"cruiectrl", "ETS2LA Cruise Control", SCS_VALUE_TYPE_bool },
+	{"cruiectrlinc", "ETS2LA Cruise Control Increase", SCS_VALUE_TYPE_bool },
+	{"cruiectrldec", "ETS2LA Cruise Control Decrease", SCS_VALUE_TYPE_bool },
+	{"cruiectrlres", "ETS2LA Cruise Control Reset", SCS_VALUE_TYPE_bool },
+	{"light", "ETS2LA Lights", SCS_VALUE_TYPE_bool },
+	{"hblight", "ETS2LA High Beams", SCS_VALUE_TYPE_bool },
+	{"lblinker", "ETS2LA Left Blinker", SCS_VALUE_TYPE_bool },
+	{"rblinker", "ETS2LA Right Blinker", SCS_VALUE_TYPE_bool },
+	{"quickpark", "ETS2LA Quickpark", SCS_VALUE_TYPE_bool },
+	{"drive", "ETS2LA Drive", SCS_VALUE_TYPE_bool },
+	{"reverse", "ETS2LA Reverse", SCS_VALUE_TYPE_bool },
+	{"cycl_zoom", "ETS2LA Cycle Zoom", SCS_VALUE_TYPE_bool },	
+	{"tripreset", "ETS2LA Reset Trip", SCS_VALUE_TYPE_bool },
+	{"wipersback", "ETS2LA Rear Wipers", SCS_VALUE_TYPE_bool },
+	{"wipers0", "ETS2LA Wiper LVL 0", SCS_VALUE_TYPE_bool },
+	{"wipers1", "ETS2LA Wiper LVL 1", SCS_VALUE_TYPE_bool },
+	{"wipers2", "ETS2LA Wiper LVL 2", SCS_VALUE_TYPE_bool },
+	{"wipers3", "ETS2LA Wiper LVL 3", SCS_VALUE_TYPE_bool },
+	{"wipers4", "ETS2LA Wiper LVL 4", SCS_VALUE_TYPE_bool },
+	{"horn", "ETS2LA Horn", SCS_VALUE_TYPE_bool },
+	{"airhorn", "ETS2LA Airhorn", SCS_VALUE_TYPE_bool },
+	{"lighthorn", "ETS2LA Light Horn", SCS_VALUE_TYPE_bool },
+	{"cam1", "ETS2LA Camera 1", SCS_VALUE_TYPE_bool },
+	{"cam2", "ETS2LA Camera 2", SCS_VALUE_TYPE_bool },
+	{"cam3", "ETS2LA Camera 3", SCS_VALUE_TYPE_bool },
+	{"cam4", "ETS2LA Camera 4", SCS_VALUE_TYPE_bool },
+	{"cam5", "ETS2LA Camera 5", SCS_VALUE_TYPE_bool },
+	{"cam6", "ETS2LA Camera 6", SCS_VALUE_TYPE_bool },
+	{"cam7", "ETS2LA Camera 7", SCS_VALUE_TYPE_bool },
+	{"cam8", "ETS2LA Camera 8", SCS_VALUE_TYPE_bool },
+	{"mapzoom_in", "ETS2LA Zoom Map In", SCS_VALUE_TYPE_bool },
+	{"mapzoom_out", "ETS2LA Zoom Map Out", SCS_VALUE_TYPE_bool },
+	{"accmode", "ETS2LA ACC Mode", SCS_VALUE_TYPE_bool },
+	{"showmirrors", "ETS2LA Show Mirrors", SCS_VALUE_TYPE_bool },
+	{"flasher4way", "ETS2LA Hazard Lights", SCS_VALUE_TYPE_bool }
+};
+
+// Inputs enabled by the configuration and their slots in the control block.
+scs_input_device_input_t registeredInputs[inputCount];
+int registeredSlots[inputCount];
+bool registeredGrouped[inputCount];
+
+void reload_config() {
+	const char* const path = config_path();
+	if (file_modification_time(path) == config->modification_time) {
+		return;
+	}
 
-	log_line("Successfully opened shared mem file.");
-}
+	config_t* const loaded = (config == &configs[0]) ? &configs[1] : &configs[0];
+	if (!config_load(path, *loaded, deviceInputs)) {
+		log_error("Failed to read configuration %s, keeping the previous one.", path);
+		config->modification_time = loaded->modification_time;
+		return;
+	}
 
-// Function to read shared memory
-std::pair<std::array<float, axisCount>, std::array<bool, buttonCount>> read_mem() {
-	if (hMapFile == NULL) {
-		log_line("Shared mem file not open.");
-		return std::make_pair(std::array<float, axisCount>{}, std::array<bool, buttonCount>{});
+	// Opening another log file would allocate, it waits for the next init.
+	log_set_level(loaded->log_level);
+	log_line("Reloaded configuration %s.", path);
+	if (loaded->error[0]) {
+		log_error("%s", loaded->error);
+	}
+	if (strcmp(loaded->device_name, config->device_name) != 0 || strcmp(loaded->display_name, config->display_name) != 0 || memcmp(loaded->input_enabled, config->input_enabled, sizeof(config->input_enabled)) != 0 ||
+		memcmp(&loaded->generic, &config->generic, sizeof(config->generic)) != 0) {
+		log_line("Device and input changes take effect after sdk reload.");
+	}
+	if (strcmp(loaded->log_file, config->log_file) != 0) {
+		log_line("Log file changes take effect after sdk reload.");
+	}
+	if (loaded->recording.enabled != config->recording.enabled || strcmp(loaded->recording.path, config->recording.path) != 0) {
+		log_line("Recording changes take effect after sdk reload.");
 	}
 
-	void* pBuf = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	config = loaded;
+
+	char name[configNameSize];
+	instance_memory_name(name, sizeof(name), config->memory_name, config->memory_namespace, gameId, config->memory_suffix);
+	if (strcmp(name, memoryName) != 0) {
+		instance_registry_remove();
+		telemetry_share(NULL);
+		frame_sync_close();
+		activity_close();
+		shared_memory_close(sharedMemory);
+		controlBlock = NULL;
+		initialize_mem();
+	}
+}
 
-	std::array<float, axisCount> floatData;
-	std::array<bool, buttonCount> boolData;
+// Fail-safe, all inputs are released when the producer heartbeat stops.
+scs_u32_t lastHeartbeat = 0;
+scs_u64_t lastHeartbeatTime = 0;
+bool failsafeActive = false;
 
-	memcpy(floatData.data(), pBuf, axisSize);
-	memcpy(boolData.data(), static_cast<char*>(pBuf) + axisSize, buttonSize);
+bool producer_stalled(const scs_u64_t now) {
+	const scs_u32_t heartbeat = controlBlock->heartbeat.load(std::memory_order_relaxed);
+	if (heartbeat != lastHeartbeat || lastHeartbeatTime == 0) {
+		lastHeartbeat = heartbeat;
+		lastHeartbeatTime = now;
+	}
 
-	UnmapViewOfFile(pBuf);
-	return std::make_pair(floatData, boolData);
+	const bool stalled = config->failsafe_timeout != 0 && now - lastHeartbeatTime > static_cast<scs_u64_t>(config->failsafe_timeout) * 1000;
+	if (stalled != failsafeActive) {
+		failsafeActive = stalled;
+		log_line(stalled ? "Producer heartbeat lost, releasing all inputs." : "Producer heartbeat is back.");
+	}
+	return stalled;
 }
 
 #define UNUSED(x)
 
-int inputNumber = 0;
-scs_float_t inputValues[axisCount];
-scs_value_bool_t inputBools[buttonCount];
-scs_input_device_t device_info;
-SCSAPI_RESULT input_event_callback(scs_input_event_t* const event_info, const scs_u32_t flags, const scs_context_t UNUSED(context))
+// Producer heartbeat seen by the previous frame, for the stale frame count.
+scs_u32_t statsHeartbeat = 0;
+
+/**
+ * @brief Everything the devices report in one game frame.
+ *
+ * The game polls every device once per frame in no fixed order. Whichever
+ * device comes first runs the frame processing, which reads the control
+ * block, and the other one reports from the same snapshot.
+ */
+struct frame_snapshot_t
+{
+	scs_u32_t frame;			// frames processed so far
+	scs_float_t values[axisCount];
+	scs_value_bool_t bools[buttonCount];
+	float generic_axes[genericAxisCount];
+	bool generic_buttons[genericButtonCount];
+};
+
+/**
+ * @brief A registered device, the callback_context of its callbacks.
+ */
+struct device_state_t
 {
-	if (inputNumber >= device_info.input_count) {
-		inputNumber = 0;
-		return SCS_RESULT_not_found;
+	scs_input_device_t info;
+	frame_snapshot_t* snapshot;
+	scs_u32_t frame;			// snapshot frame the pending inputs were taken from
+	bool active;
+	int* pending;				// inputs to report in this frame, as indices of info.inputs
+	int pending_count;
+	int event_number;
+};
+
+frame_snapshot_t frameSnapshot;
+
+// Processes a frame into the snapshot, instantiated per game by select_game.
+typedef void (*frame_processor_t)(frame_snapshot_t& snapshot);
+frame_processor_t processFrame = NULL;
+
+// Inputs reported in the current frame, as indices of the registered inputs.
+int pendingInputs[inputCount];
+bool reportedBools[buttonCount];
+device_state_t semanticalDevice;
+
+// The registered names are copied, config points into the configs double
+// buffer which every second reload overwrites.
+char deviceName[configNameSize];
+char deviceDisplayName[configNameSize];
+
+// The generic device, axes first and then the buttons. The game keeps the
+// last value of every input, so only changes are reported.
+char genericInputNames[SCS_INPUT_MAX_INPUT_COUNT][16];
+char genericInputDisplayNames[SCS_INPUT_MAX_INPUT_COUNT][genericNameSize];
+char genericDeviceName[configNameSize];
+char genericDisplayName[configNameSize];
+scs_input_device_input_t genericInputs[SCS_INPUT_MAX_INPUT_COUNT];
+int genericPending[SCS_INPUT_MAX_INPUT_COUNT];
+float genericReported[SCS_INPUT_MAX_INPUT_COUNT];
+scs_u32_t genericAxes = 0;
+device_state_t genericDevice;
+
+static_assert(genericAxisCount + genericButtonCount <= static_cast<int>(SCS_INPUT_MAX_INPUT_COUNT), "too many generic inputs");
+
+SCSAPI_VOID input_active_callback(const scs_u8_t active, const scs_context_t context)
+{
+	device_state_t& device = *static_cast<device_state_t*>(context);
+	device.active = active != 0;
+	activity_set_device_active(semanticalDevice.active || genericDevice.active);
+}
+
+// Instantiated per game, game_t decides which mixes exist.
+template <typename game_t>
+void process_frame(frame_snapshot_t& snapshot)
+{
+	const scs_u64_t faultsBefore = page_fault_count();
+
+	// Pick up configuration changes, checking the file every few frames.
+	if (config->reload_frames != 0 && ++framesSinceReloadCheck >= config->reload_frames) {
+		framesSinceReloadCheck = 0;
+		reload_config();
+	}
+
+	// Publish the frame, in lockstep mode this waits for the producer.
+	if (controlBlock) {
+		frame_sync_begin_frame(controlBlock->sync);
+	}
+	const scs_u64_t processingStart = monotonic_time_us();
+	int tornReads = 0;
+	bool stalled = false;
+
+	// Read the shared block and route the slots to the inputs.
+	float slots[inputCount];
+	float values[axisCount];
+	bool bools[buttonCount];
+	read_mem(slots);
+	if (controlBlock) {
+		input_group_expand(controlBlock->groups, slots);
+
+		// Inputs owned by the producer slots override the shared block.
+		const scs_u64_t now = controlBlock->sync.frame_time.load(std::memory_order_relaxed);
+		tornReads = arbitration_merge(controlBlock->producers, now, static_cast<scs_u64_t>(config->producer_timeout) * 1000, slots);
+		memcpy(snapshot.generic_axes, controlBlock->generic.axes, sizeof(snapshot.generic_axes));
+		memcpy(snapshot.generic_buttons, controlBlock->generic.buttons, sizeof(snapshot.generic_buttons));
+	}
+	else {
+		memset(snapshot.generic_axes, 0, sizeof(snapshot.generic_axes));
+		memset(snapshot.generic_buttons, 0, sizeof(snapshot.generic_buttons));
+	}
+	input_map_gather(config->map, slots, values, bools);
+
+	// Shape the raw producer values, the trajectory and the controllers
+	// below already work in output units.
+	curve_apply(config->tables, values, axisCount);
+
+	// A producer trajectory replaces the wheel and the pedals, sampled
+	// at the time this frame started.
+	if (controlBlock) {
+		const scs_u64_t now = controlBlock->sync.frame_time.load(std::memory_order_relaxed);
+		trajectory_sample(controlBlock->trajectory, now, values[axis_steering], values[axis_aforward], values[axis_abackward]);
+
+		// Optional work is suspended while the game is paused.
+		const bool busy = activity_busy();
+
+		// Targets for the in-plugin controllers take precedence.
+		if (busy) {
+			controller_update(controlBlock->controller, telemetry, now, values);
+		}
+
+		// Calibrate the steering, or treat the steering value as the
+		// desired effective steering when a calibration is loaded.
+		if (busy) {
+			steering_calibration_update(controlBlock->calibration, telemetry, now, values[axis_steering], config->steering_table, config->calibration_file);
+		}
+		if (config->calibration_enabled && config->steering_table.valid && !steering_calibration_running()) {
+			values[axis_steering] = steering_calibration_apply(config->steering_table, telemetry.speed, values[axis_steering]);
+		}
+
+		// The driver wins over all of the above.
+		human_override_update(controlBlock->human_override, config->human_override, telemetry, now, values);
+
+		// Rules over the telemetry and the inputs.
+		if (busy) {
+			rule_run(config->rules, telemetry, values, bools);
+		}
+
+		// Buttons held by the running macros.
+		macro_update(controlBlock->macros, now, bools);
+
+		stalled = producer_stalled(now);
+		if (stalled) {
+			memset(values, 0, sizeof(values));
+			memset(bools, 0, sizeof(bools));
+			memset(snapshot.generic_axes, 0, sizeof(snapshot.generic_axes));
+			memset(snapshot.generic_buttons, 0, sizeof(snapshot.generic_buttons));
+		}
 	}
 
+	// Mixes the game does not have stay released.
+	constexpr input_mask_t supported = game_input_all<game_t>();
+	for (int i = 0; i < axisCount; i++)
+	{
+		if (!(supported & (input_mask_t(1) << i))) {
+			values[i] = 0.0f;
+		}
+	}
+	for (int i = 0; i < buttonCount; i++)
+	{
+		if (!(supported & (input_mask_t(1) << (axisCount + i)))) {
+			bools[i] = false;
+		}
+	}
+
+	for (int i = 0; i < axisCount; i++)
+	{
+		if (values[i] > 1.0) {
+			values[i] = 1.0;
+		}
+		if (values[i] < -1.0) {
+			values[i] = -1.0;
+		}
+		snapshot.values[i] = values[i];
+	}
+	for (int i = 0; i < genericAxisCount; i++)
+	{
+		const float value = snapshot.generic_axes[i];
+		snapshot.generic_axes[i] = value > 1.0f ? 1.0f : (value < -1.0f ? -1.0f : value);
+	}
+
+	// Set the bools
+	for (int i = 0; i < buttonCount; i++)
+	{
+		snapshot.bools[i].value = bools[i];
+	}
+	snapshot.frame++;
+
+	if (controlBlock) {
+		// Stale when no producer committed anything since the previous frame.
+		const scs_u32_t heartbeat = controlBlock->heartbeat.load(std::memory_order_relaxed);
+		const bool stale = heartbeat != 0 && heartbeat == statsHeartbeat;
+		statsHeartbeat = heartbeat;
+		stats_frame(controlBlock->stats, monotonic_time_us() - processingStart, tornReads, stale, stalled, page_fault_count() - faultsBefore);
+	}
+}
+
+// Called for the first event of a device in a frame. Processes the frame
+// unless the other device already did since this one last reported.
+void begin_device_frame(device_state_t& device, const scs_u32_t flags)
+{
 	if (flags & SCS_INPUT_EVENT_CALLBACK_FLAG_first_after_activation) {
-		log_line("First call after activation");
+		log_line("First call after activation of %s", device.info.name);
+
+		// Also covers hosts which do not report the activity separately.
+		device.active = true;
+		activity_set_device_active(true);
 	}
+	if (device.frame == device.snapshot->frame) {
+		processFrame(*device.snapshot);
+	}
+	device.frame = device.snapshot->frame;
+	device.pending_count = 0;
+	device.event_number = 0;
+}
 
-	if (SCS_INPUT_EVENT_CALLBACK_FLAG_first_in_frame == 1 && inputNumber == 0) {
-		inputNumber = 0;
+SCSAPI_RESULT semantical_event_callback(scs_input_event_t* const event_info, const scs_u32_t flags, const scs_context_t context)
+{
+	device_state_t& device = *static_cast<device_state_t*>(context);
+	const frame_snapshot_t& snapshot = *device.snapshot;
 
-		// Read the floats from shared memory
-		std::pair<std::array<float, axisCount>, std::array<bool, buttonCount>> data = read_mem();
-		std::array<float, axisCount> values = data.first;
-		std::array<bool, buttonCount> bools = data.second;
+	if (flags & SCS_INPUT_EVENT_CALLBACK_FLAG_first_in_frame) {
+		begin_device_frame(device, flags);
 
-		for (int i = 0; i < axisCount; i++)
+		// Every input is reported each frame except the group members which
+		// are only reported when they change, or all of them after activation.
+		const bool resync = (flags & SCS_INPUT_EVENT_CALLBACK_FLAG_first_after_activation) != 0;
+		for (scs_u32_t i = 0; i < device.info.input_count; i++)
 		{
-			if (values[i] > 1.0) {
-				values[i] = 1.0;
+			const int slot = registeredSlots[i];
+			if (registeredGrouped[i] && !resync && reportedBools[slot - axisCount] == (snapshot.bools[slot - axisCount].value != 0)) {
+				continue;
 			}
-			if (values[i] < -1.0) {
-				values[i] = -1.0;
-			}
-			inputValues[i] = values[i];
+			device.pending[device.pending_count++] = i;
 		}
+	}
 
-		// Set the bools
-		for (int i = 0; i < buttonCount; i++)
-		{
-			inputBools[i].value = bools[i];
-		}
+	if (device.event_number >= device.pending_count) {
+		device.event_number = 0;
+		device.pending_count = 0;
+		return SCS_RESULT_not_found;
 	}
 
-	event_info->input_index = inputNumber;
+	const int input = device.pending[device.event_number++];
+	event_info->input_index = input;
 
-	if (inputNumber < axisCount)
+	const int slot = registeredSlots[input];
+	if (slot < axisCount)
 	{
-		event_info->value_float.value = inputValues[inputNumber];
+		event_info->value_float.value = snapshot.values[slot];
 	}
 	else
 	{
-		// We need to remove the axis count from the input number to get the correct index for the bools
-		event_info->value_bool.value = inputBools[inputNumber - axisCount].value;
+		// We need to remove the axis count from the slot to get the correct index for the bools
+		event_info->value_bool.value = snapshot.bools[slot - axisCount].value;
+		reportedBools[slot - axisCount] = snapshot.bools[slot - axisCount].value != 0;
+	}
+
+	return SCS_RESULT_ok;
+}
+
+float generic_value(const frame_snapshot_t& snapshot, const scs_u32_t input)
+{
+	if (input < genericAxes) {
+		return snapshot.generic_axes[input];
+	}
+	return snapshot.generic_buttons[input - genericAxes] ? 1.0f : 0.0f;
+}
+
+SCSAPI_RESULT generic_event_callback(scs_input_event_t* const event_info, const scs_u32_t flags, const scs_context_t context)
+{
+	device_state_t& device = *static_cast<device_state_t*>(context);
+	const frame_snapshot_t& snapshot = *device.snapshot;
+
+	if (flags & SCS_INPUT_EVENT_CALLBACK_FLAG_first_in_frame) {
+		begin_device_frame(device, flags);
+
+		const bool resync = (flags & SCS_INPUT_EVENT_CALLBACK_FLAG_first_after_activation) != 0;
+		for (scs_u32_t i = 0; i < device.info.input_count; i++)
+		{
+			if (resync || generic_value(snapshot, i) != genericReported[i]) {
+				device.pending[device.pending_count++] = i;
+			}
+		}
+	}
+
+	if (device.event_number >= device.pending_count) {
+		device.event_number = 0;
+		device.pending_count = 0;
+		return SCS_RESULT_not_found;
 	}
 
-	inputNumber++;
+	const int input = device.pending[device.event_number++];
+	event_info->input_index = input;
+	const float value = generic_value(snapshot, input);
+	if (static_cast<scs_u32_t>(input) < genericAxes) {
+		event_info->value_float.value = value;
+	}
+	else {
+		event_info->value_bool.value = value != 0.0f;
+	}
+	genericReported[input] = value;
 
 	return SCS_RESULT_ok;
 }
 
+/**
+ * @brief Checks the game version and picks the mixes and the frame processing of the game.
+ */
+template <typename game_t>
+bool select_game(const scs_u32_t version, input_mask_t& inputs, frame_processor_t& processor)
+{
+	if (version < game_t::minimum_version) {
+		log_error("Game version %u.%u of %s is too old.", SCS_GET_MAJOR_VERSION(version), SCS_GET_MINOR_VERSION(version), game_t::name());
+		return false;
+	}
+	if (SCS_GET_MAJOR_VERSION(version) > SCS_GET_MAJOR_VERSION(game_t::current_version)) {
+		log_line("Game version %u.%u of %s is newer than this plugin, registering the known mixes only.", SCS_GET_MAJOR_VERSION(version), SCS_GET_MINOR_VERSION(version), game_t::name());
+	}
+	inputs = game_input_mask<game_t>(version);
+	processor = process_frame<game_t>;
+	return true;
+}
+
+// Undoes scs_input_init, at shutdown and when the init fails after it
+// created the shared memory.
+void release_instance() {
+	release_memory();
+	instance_registry_remove();
+	telemetry_share(NULL);
+	frame_sync_close();
+	activity_close();
+	shared_memory_close(sharedMemory);
+	controlBlock = NULL;
+	finish_log();
+
+	config = NULL;
+}
+
+// Registers the axes and buttons of [generic] for binding in the game UI.
+bool register_generic_device(const scs_input_init_params_v100_t* const params)
+{
+	const generic_config_t& generic = config->generic;
+	genericAxes = generic.axes;
+	scs_u32_t count = 0;
+	for (scs_u32_t i = 0; i < generic.axes; i++, count++)
+	{
+		snprintf(genericInputNames[count], sizeof(genericInputNames[count]), "axis%u", i);
+		genericInputs[count].name = genericInputNames[count];
+		snprintf(genericInputDisplayNames[count], sizeof(genericInputDisplayNames[count]), "%s", generic.axis_names[i]);
+		genericInputs[count].display_name = genericInputDisplayNames[count];
+		genericInputs[count].value_type = SCS_VALUE_TYPE_float;
+	}
+	for (scs_u32_t i = 0; i < generic.buttons; i++, count++)
+	{
+		snprintf(genericInputNames[count], sizeof(genericInputNames[count]), "button%u", i);
+		genericInputs[count].name = genericInputNames[count];
+		snprintf(genericInputDisplayNames[count], sizeof(genericInputDisplayNames[count]), "%s", generic.button_names[i]);
+		genericInputs[count].display_name = genericInputDisplayNames[count];
+		genericInputs[count].value_type = SCS_VALUE_TYPE_bool;
+	}
+	memset(genericReported, 0, sizeof(genericReported));
+
+	scs_input_device_t& info = genericDevice.info;
+	snprintf(genericDeviceName, sizeof(genericDeviceName), "%s", generic.device_name);
+	snprintf(genericDisplayName, sizeof(genericDisplayName), "%s", generic.display_name);
+	info.name = genericDeviceName;
+	info.display_name = genericDisplayName;
+	info.type = SCS_INPUT_DEVICE_TYPE_generic;
+	info.input_count = count;
+	info.inputs = genericInputs;
+	info.input_active_callback = input_active_callback;
+	info.input_event_callback = generic_event_callback;
+	info.callback_context = &genericDevice;
+	genericDevice.snapshot = &frameSnapshot;
+	genericDevice.pending = genericPending;
+
+	log_line("Registering generic device %s with %u axes and %u buttons.", generic.device_name, generic.axes, generic.buttons);
+	return params->register_device(&info) == SCS_RESULT_ok;
+}
+
 /**
  * @brief Input API initialization function.
  *
@@ -221,123 +790,103 @@ SCSAPI_RESULT input_event_callback(scs_input_event_t* const event_info, const sc
  */
 SCSAPI_RESULT scs_input_init(const scs_u32_t version, const scs_input_init_params_t *const params)
 {
-	init_log();
-
 	// We currently support only one version.
 	if (version != SCS_INPUT_VERSION_1_00) {
 		return SCS_RESULT_unsupported;
 	}
 
-	initialize_mem();
+	const char* const path = config_path();
+	config = &configs[0];
+	const bool configLoaded = config_load(path, *config, deviceInputs);
+	framesSinceReloadCheck = 0;
+
+	log_configure(config->log_file, config->log_level);
+	init_log();
+	if (configLoaded) {
+		log_line("Loaded configuration %s.", path);
+	}
+	else {
+		log_line("No configuration %s, using the defaults.", path);
+	}
+	if (config->error[0]) {
+		log_error("%s", config->error);
+	}
 
 	const scs_input_init_params_v100_t *const version_params = static_cast<const scs_input_init_params_v100_t *>(params);
+	strncpy(gameId, version_params->common.game_id, sizeof(gameId) - 1);
+	gameId[sizeof(gameId) - 1] = '\0';
+	gameVersion = version_params->common.game_version;
+
+	input_mask_t gameInputs = 0;
+	bool selected = false;
+	if (strcmp(gameId, SCS_GAME_ID_EUT2) == 0) {
+		selected = select_game<game_eut2_t>(gameVersion, gameInputs, processFrame);
+	}
+	else if (strcmp(gameId, SCS_GAME_ID_ATS) == 0) {
+		selected = select_game<game_ats_t>(gameVersion, gameInputs, processFrame);
+	}
+	else {
+		log_error("Unsupported game %s.", gameId);
+	}
+	if (!selected) {
+		finish_log();
+		config = NULL;
+		return SCS_RESULT_unsupported;
+	}
 
-	// Setup the device information. The name of the input matches the name of the
-	// mix as seen in controls.sii. Note that only some inputs are supported this way.
-	// See documentation of SCS_INPUT_DEVICE_TYPE_semantical
+	initialize_mem();
+	telemetry_configure_recording(config->recording.enabled, config->recording.path);
+	prepare_memory();
 
-	memset(&device_info, 0, sizeof(device_info));
-	device_info.name = "laneassist";
-	device_info.display_name = "ETS2 Lane Assist";
+	// Both devices report from one snapshot per frame.
+	memset(&frameSnapshot, 0, sizeof(frameSnapshot));
+
+	// Setup the device information.
+
+	memset(&semanticalDevice, 0, sizeof(semanticalDevice));
+	scs_input_device_t& device_info = semanticalDevice.info;
+	snprintf(deviceName, sizeof(deviceName), "%s", config->device_name);
+	snprintf(deviceDisplayName, sizeof(deviceDisplayName), "%s", config->display_name);
+	device_info.name = deviceName;
+	device_info.display_name = deviceDisplayName;
 	device_info.type = SCS_INPUT_DEVICE_TYPE_semantical;
 
-	// These are all the somewhat useful commands from the controls
-	// Name, Index, Type, Control Name In File
-	// Steering, 0, float, steering
-	// Acceleration, 1, float, aforward
-	// Braking, 2, float, abackward
-	// Clutch, 3, float, clutch
-	// Pause Game, 4, bool,
-	// Parking Brake, 5, bool, parkingbrake
-	// Wipers, 6, bool, wipers
-	// Cruise Control, 7, bool, cruiectrl
-	// Cruise Control Increase, 8, bool, cruiectrlinc
-	// Cruise Control Decrease, 9, bool, cruiectrldec
-	// Cruise Control Reset, 10, bool, cruiectrlres
-	// Lights, 11, bool, light
-	// High Beams, 12, bool, hblight
-	// Left Blinker, 13, bool, lblinker
-	// Right Blinker, 14, bool, rblinker
-	// Quickpark, 15, bool, quickpark
-	// Drive(Gear), 16, bool, drive
-	// Reverse(Gear), 17, bool, reverse
-	// Cycle Zoom(map ? ), 18, bool, cycl_zoom
-	// Reset Trip, 19, bool, tripreset
-	// Rear Wipers, 20, bool, wipersback
-	// Wiper LVL 0, 21, bool, wipers0
-	// Wiper LVL 1, 22, bool, wipers1
-	// Wiper LVL 2, 23, bool, wipers2
-	// Wiper LVL 3, 24, bool, wipers3
-	// Wiper LVL 4, 25, bool, wipers4
-	// Horn, 26, bool, horn
-	// Airhorn, 27, bool, airhorn
-	// Light Horn, 28, bool, lighthorn
-	// Camera 1, 29, bool, cam1
-	// Camera 2, 30, bool, cam2
-	// Camera 3, 31, bool, cam3
-	// Camera 4, 32, bool, cam4
-	// Camera 5, 33, bool, cam5
-	// Camera 6, 34, bool, cam6
-	// Camera 7, 35, bool, cam7
-	// Camera 8, 36, bool, cam8
-	// Zoom Map In, 37, bool, mapzoom_in
-	// Zoom Map Out, 38, bool, mapzoom_out
-	// ACC Mode, 39, bool, accmode
-	// Show Mirrors, 40, bool, showmirrors
-	// Hazard Lights, 41, bool, flasher4way
-
-	const scs_input_device_input_t inputs[] = { 
-		{"steering", "ETS2LA Steering", SCS_VALUE_TYPE_float }, 
-		{"aforward", "ETS2LA Forward", SCS_VALUE_TYPE_float }, 
-		{"abackward", "ETS2LA Backward", SCS_VALUE_TYPE_float },
-		{"clutch", "ETS2LA Clutch", SCS_VALUE_TYPE_float },
-		{"pause", "ETS2LA Pause", SCS_VALUE_TYPE_bool },
-		{"parkingbrake", "ETS2LA Parking Brake", SCS_VALUE_TYPE_bool },
-		{"wipers", "ETS2LA Wipers", SCS_VALUE_TYPE_bool },
-		{"cruiectrl", "ETS2LA Cruise Control", SCS_VALUE_TYPE_bool },
-		{"cruiectrlinc", "ETS2LA Cruise Control Increase", SCS_VALUE_TYPE_bool },
-		{"cruiectrldec", "ETS2LA Cruise Control Decrease", SCS_VALUE_TYPE_bool },
-		{"cruiectrlres", "ETS2LA Cruise Control Reset", SCS_VALUE_TYPE_bool },
-		{"light", "ETS2LA Lights", SCS_VALUE_TYPE_bool },
-		{"hblight", "ETS2LA High Beams", SCS_VALUE_TYPE_bool },
-		{"lblinker", "ETS2LA Left Blinker", SCS_VALUE_TYPE_bool },
-		{"rblinker", "ETS2LA Right Blinker", SCS_VALUE_TYPE_bool },
-		{"quickpark", "ETS2LA Quickpark", SCS_VALUE_TYPE_bool },
-		{"drive", "ETS2LA Drive", SCS_VALUE_TYPE_bool },
-		{"reverse", "ETS2LA Reverse", SCS_VALUE_TYPE_bool },
-		{"cycl_zoom", "ETS2LA Cycle Zoom", SCS_VALUE_TYPE_bool },	
-		{"tripreset", "ETS2LA Reset Trip", SCS_VALUE_TYPE_bool },
-		{"wipersback", "ETS2LA Rear Wipers", SCS_VALUE_TYPE_bool },
-		{"wipers0", "ETS2LA Wiper LVL 0", SCS_VALUE_TYPE_bool },
-		{"wipers1", "ETS2LA Wiper LVL 1", SCS_VALUE_TYPE_bool },
-		{"wipers2", "ETS2LA Wiper LVL 2", SCS_VALUE_TYPE_bool },
-		{"wipers3", "ETS2LA Wiper LVL 3", SCS_VALUE_TYPE_bool },
-		{"wipers4", "ETS2LA Wiper LVL 4", SCS_VALUE_TYPE_bool },
-		{"horn", "ETS2LA Horn", SCS_VALUE_TYPE_bool },
-		{"airhorn", "ETS2LA Airhorn", SCS_VALUE_TYPE_bool },
-		{"lighthorn", "ETS2LA Light Horn", SCS_VALUE_TYPE_bool },
-		{"cam1", "ETS2LA Camera 1", SCS_VALUE_TYPE_bool },
-		{"cam2", "ETS2LA Camera 2", SCS_VALUE_TYPE_bool },
-		{"cam3", "ETS2LA Camera 3", SCS_VALUE_TYPE_bool },
-		{"cam4", "ETS2LA Camera 4", SCS_VALUE_TYPE_bool },
-		{"cam5", "ETS2LA Camera 5", SCS_VALUE_TYPE_bool },
-		{"cam6", "ETS2LA Camera 6", SCS_VALUE_TYPE_bool },
-		{"cam7", "ETS2LA Camera 7", SCS_VALUE_TYPE_bool },
-		{"cam8", "ETS2LA Camera 8", SCS_VALUE_TYPE_bool },
-		{"mapzoom_in", "ETS2LA Zoom Map In", SCS_VALUE_TYPE_bool },
-		{"mapzoom_out", "ETS2LA Zoom Map Out", SCS_VALUE_TYPE_bool },
-		{"accmode", "ETS2LA ACC Mode", SCS_VALUE_TYPE_bool },
-		{"showmirrors", "ETS2LA Show Mirrors", SCS_VALUE_TYPE_bool },
-		{"flasher4way", "ETS2LA Hazard Lights", SCS_VALUE_TYPE_bool }
-	};
-	device_info.input_count = axisCount + buttonCount;
-	device_info.inputs = inputs;
-
-	device_info.input_event_callback = input_event_callback;
-	device_info.callback_context = NULL;
+	scs_u32_t registeredCount = 0;
+	for (int i = 0; i < inputCount; i++)
+	{
+		if (!(gameInputs & (input_mask_t(1) << i))) {
+			log_debug("Game has no mix %s.", deviceInputs[i].name);
+			continue;
+		}
+		if (config->input_enabled[i]) {
+			registeredInputs[registeredCount] = deviceInputs[i];
+			registeredSlots[registeredCount] = i;
+			registeredGrouped[registeredCount] = input_group_member(i);
+			registeredCount++;
+		}
+	}
+	device_info.input_count = registeredCount;
+	log_line("Registering %u inputs for %s %u.%u.", registeredCount, gameId, SCS_GET_MAJOR_VERSION(gameVersion), SCS_GET_MINOR_VERSION(gameVersion));
+	device_info.inputs = registeredInputs;
+	semanticalDevice.snapshot = &frameSnapshot;
+	semanticalDevice.pending = pendingInputs;
+
+	device_info.input_active_callback = input_active_callback;
+	device_info.input_event_callback = semantical_event_callback;
+	device_info.callback_context = &semanticalDevice;
 
 	if (version_params->register_device(&device_info) != SCS_RESULT_ok) {
 		version_params->common.log(SCS_LOG_TYPE_error, "Unable to register device");
+		log_error("Unable to register device %s.", deviceName);
+		release_instance();
+		return SCS_RESULT_generic_error;
+	}
+
+	memset(&genericDevice, 0, sizeof(genericDevice));
+	if (config->generic.enabled && !register_generic_device(version_params)) {
+		version_params->common.log(SCS_LOG_TYPE_error, "Unable to register the generic device");
+		log_error("Unable to register the generic device %s.", genericDeviceName);
+		release_instance();
 		return SCS_RESULT_generic_error;
 	}
 
@@ -352,7 +901,7 @@ SCSAPI_RESULT scs_input_init(const scs_u32_t version, const scs_input_init_param
  */
 SCSAPI_VOID scs_input_shutdown(void)
 {
-	finish_log();
+	release_instance();
 }
 
 // Cleanup
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "instance_registry.h"
+#include "log.h"
+#include "platform.h"
+
+static shared_memory_t registryMemory;
+static registry_t* registry = NULL;
+static registry_entry_t* entry = NULL;
+
+static void copy_string(char* const destination, const char* const source, const size_t size)
+{
+	strncpy(destination, source, size - 1);
+	destination[size - 1] = '\0';
+}
+
+void instance_memory_name(char* const result, const size_t size, const char* const base, const memory_namespace_t space, const char* const game_id, const char* const suffix)
+{
+	int length = snprintf(result, size, "%s", base);
+	if (space != memory_namespace_shared && length >= 0 && static_cast<size_t>(length) < size) {
+		length += snprintf(result + length, size - length, ".%s", game_id);
+	}
+	if (space == memory_namespace_instance && length >= 0 && static_cast<size_t>(length) < size) {
+		length += snprintf(result + length, size - length, ".%u", process_id());
+	}
+	if (suffix && *suffix && length >= 0 && static_cast<size_t>(length) < size) {
+		snprintf(result + length, size - length, ".%s", suffix);
+	}
+}
+
+// Reads an entry written by another process, false when it is free or keeps changing.
+static bool read_entry(const registry_entry_t& source, instance_info_t& copy)
+{
+	for (int attempt = 0; attempt < 16; attempt++)
+	{
+		const scs_u32_t before = source.sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;
+		}
+		copy.pid = source.pid.load(std::memory_order_relaxed);
+		copy.game_version = source.game_version;
+		copy.start_time = source.start_time;
+		memcpy(copy.game_id, source.game_id, sizeof(copy.game_id));
+		memcpy(copy.name, source.name, sizeof(copy.name));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (source.sequence.load(std::memory_order_relaxed) == before) {
+			copy.game_id[registryGameIdSize - 1] = '\0';
+			copy.name[registryNameSize - 1] = '\0';
+			return copy.pid != 0;
+		}
+	}
+	return false;
+}
+
+static void write_entry(registry_entry_t& target, const char* const name, const char* const game_id, const scs_u32_t game_version)
+{
+	const scs_u32_t sequence = target.sequence.load(std::memory_order_relaxed);
+	target.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	target.game_version = game_version;
+	target.start_time = monotonic_time_us();
+	copy_string(target.game_id, game_id, sizeof(target.game_id));
+	copy_string(target.name, name, sizeof(target.name));
+	target.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool instance_registry_add(const char* const name, const char* const game_id, const scs_u32_t game_version)
+{
+	instance_registry_remove();
+
+	if (strlen(name) >= static_cast<size_t>(registryNameSize)) {
+		log_error("Memory name %s is too long for the instance registry.", name);
+		return false;
+	}
+	if (!shared_memory_attach(registryMemory, registryName, sizeof(registry_t))) {
+		log_error("Failed to open the instance registry %s.", registryName);
+		return false;
+	}
+	registry = static_cast<registry_t*>(registryMemory.data);
+
+	const scs_u32_t self = process_id();
+	registry_entry_t* claimed = NULL;
+	for (int i = 0; i < registryEntryCount; i++)
+	{
+		registry_entry_t& candidate = registry->entries[i];
+		scs_u32_t owner = candidate.pid.load(std::memory_order_acquire);
+		if (owner != 0 && process_alive(owner)) {
+			instance_info_t other;
+			if (read_entry(candidate, other) && strcmp(other.name, name) == 0) {
+				log_error("Memory name %s is also used by process %u.", name, other.pid);
+			}
+			continue;
+		}
+		// Free or left behind by a crashed process.
+		if (!claimed && candidate.pid.compare_exchange_strong(owner, self, std::memory_order_acq_rel)) {
+			claimed = &candidate;
+		}
+	}
+
+	if (!claimed) {
+		log_error("Instance registry %s is full.", registryName);
+		shared_memory_close(registryMemory);
+		registry = NULL;
+		return false;
+	}
+
+	write_entry(*claimed, name, game_id, game_version);
+	entry = claimed;
+	registry->changes.fetch_add(1, std::memory_order_release);
+	log_line("Registered %s for %s in the instance registry.", name, game_id);
+	return true;
+}
+
+void instance_registry_remove(void)
+{
+	if (!registry) {
+		return;
+	}
+	if (entry) {
+		entry->pid.store(0, std::memory_order_release);
+		registry->changes.fetch_add(1, std::memory_order_release);
+		entry = NULL;
+	}
+	shared_memory_close(registryMemory);
+	registry = NULL;
+}
+
+int instance_registry_list(instance_info_t* const instances, const int capacity)
+{
+	shared_memory_t memory;
+	if (!shared_memory_open(memory, registryName, sizeof(registry_t))) {
+		return 0;
+	}
+	const registry_t& list = *static_cast<const registry_t*>(memory.data);
+
+	int count = 0;
+	for (int i = 0; i < registryEntryCount && count < capacity; i++)
+	{
+		instance_info_t& instance = instances[count];
+		if (read_entry(list.entries[i], instance) && process_alive(instance.pid)) {
+			count++;
+		}
+	}
+	shared_memory_close(memory);
+	return count;
+}
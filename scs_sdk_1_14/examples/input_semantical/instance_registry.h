@@ -0,0 +1,41 @@
+#ifndef INPUT_SEMANTICAL_INSTANCE_REGISTRY_H
+#define INPUT_SEMANTICAL_INSTANCE_REGISTRY_H
+
+#include <stddef.h>
+
+#include "control_layout.h"
+
+// How the memory name of the control block is derived from the configured one.
+enum memory_namespace_t
+{
+	memory_namespace_shared,	// as configured, one block for all games
+	memory_namespace_game,		// one block per game, e.g. Local\SCSControls.eut2
+	memory_namespace_instance	// one block per process, e.g. Local\SCSControls.ats.4711
+};
+
+// Plain copy of a live registry entry.
+struct instance_info_t
+{
+	scs_u32_t pid;
+	scs_u32_t game_version;
+	scs_u64_t start_time;
+	char game_id[registryGameIdSize];
+	char name[registryNameSize];
+};
+
+/**
+ * @brief Builds the memory name of this instance.
+ *
+ * The game id and the process id are appended depending on the namespace,
+ * the suffix always when it is not empty.
+ */
+void instance_memory_name(char* const result, const size_t size, const char* const base, const memory_namespace_t space, const char* const game_id, const char* const suffix);
+
+// Announces the control block of this process, replacing a previous announcement.
+bool instance_registry_add(const char* const name, const char* const game_id, const scs_u32_t game_version);
+void instance_registry_remove(void);
+
+// Copies the entries of running instances, returns their number.
+int instance_registry_list(instance_info_t* const instances, const int capacity);
+
+#endif // INPUT_SEMANTICAL_INSTANCE_REGISTRY_H
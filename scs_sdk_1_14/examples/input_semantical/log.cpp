@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "log.h"
+
+// Management of the log file.
+FILE* log_file = NULL;
+char log_path[256] = "input.log";
+log_level_t log_level = log_level_info;
+
+// Given to stdio, which would otherwise allocate one on the first write
+// from whatever callback logs first.
+static char logBuffer[BUFSIZ];
+
+bool init_log(void)
+{
+	if (log_file) {
+		return true;
+	}
+	log_file = fopen(log_path, "wt");
+	if (!log_file) {
+		return false;
+	}
+	setvbuf(log_file, logBuffer, _IOFBF, sizeof(logBuffer));
+	fprintf(log_file, "Log opened\n");
+	return true;
+}
+
+void finish_log(void)
+{
+	if (!log_file) {
+		return;
+	}
+	fprintf(log_file, "Log ended\n");
+	fclose(log_file);
+	log_file = NULL;
+}
+
+void log_configure(const char* const path, const log_level_t level)
+{
+	log_level = level;
+	if (strcmp(path, log_path) == 0) {
+		return;
+	}
+
+	const bool reopen = log_file != NULL;
+	finish_log();
+	strncpy(log_path, path, sizeof(log_path) - 1);
+	log_path[sizeof(log_path) - 1] = '\0';
+	if (reopen) {
+		init_log();
+	}
+}
+
+void log_set_level(const log_level_t level)
+{
+	log_level = level;
+}
+
+static void log_write(const log_level_t level, const char* const text, va_list args)
+{
+	if (!log_file || level > log_level) {
+		return;
+	}
+	vfprintf(log_file, text, args);
+	fprintf(log_file, "\n");
+}
+
+void log_print(const char* const text, ...)
+{
+	if (!log_file || log_level < log_level_info) {
+		return;
+	}
+	va_list args;
+	va_start(args, text);
+	vfprintf(log_file, text, args);
+	va_end(args);
+}
+
+void log_line(const char* const text, ...)
+{
+	va_list args;
+	va_start(args, text);
+	log_write(log_level_info, text, args);
+	va_end(args);
+}
+
+void log_error(const char* const text, ...)
+{
+	va_list args;
+	va_start(args, text);
+	log_write(log_level_error, text, args);
+	va_end(args);
+}
+
+void log_debug(const char* const text, ...)
+{
+	va_list args;
+	va_start(args, text);
+	log_write(log_level_debug, text, args);
+	va_end(args);
+}
@@ -0,0 +1,26 @@
+#ifndef INPUT_SEMANTICAL_LOG_H
+#define INPUT_SEMANTICAL_LOG_H
+
+enum log_level_t
+{
+	log_level_none,
+	log_level_error,
+	log_level_info,
+	log_level_debug
+};
+
+// Management of the log file.
+bool init_log(void);
+void finish_log(void);
+void log_print(const char* const text, ...);
+void log_line(const char* const text, ...);
+void log_error(const char* const text, ...);
+void log_debug(const char* const text, ...);
+
+// Switches the log file (reopening it when already open) and the level.
+void log_configure(const char* const path, const log_level_t level);
+
+// Only changes the level, for the configuration reloads inside the callbacks.
+void log_set_level(const log_level_t level);
+
+#endif // INPUT_SEMANTICAL_LOG_H
@@ -0,0 +1,145 @@
+#include <string.h>
+
+#include "macro.h"
+
+struct running_macro_t
+{
+	bool active;
+	int pc;
+	scs_u32_t instruction_count;
+	macro_instruction_t instructions[macroMaxInstructions];
+	scs_u64_t wait_frame;		// frame before which the macro sleeps
+	scs_u64_t wait_time;		// time before which the macro sleeps
+	int release_input;		// released when a hold ends, -1 = none
+};
+
+static running_macro_t macros[macroMaxRunning];
+// Buttons pressed by press, until any macro releases them, and the number of
+// holds running on every button, so each hold only ends its own.
+static bool pressed[buttonCount];
+static int holds[buttonCount];
+static scs_u64_t frame = 0;
+
+static bool is_button(const int input)
+{
+	return input >= axisCount && input < inputCount;
+}
+
+// Takes one submitted macro from the queue, false when there is none.
+static bool dequeue(macro_queue_t& queue, running_macro_t& macro)
+{
+	const scs_u32_t head = queue.head.load(std::memory_order_relaxed);
+	macro_entry_t& entry = queue.entries[head % macroQueueLength];
+	if (entry.sequence.load(std::memory_order_acquire) != head + 1) {
+		return false;
+	}
+
+	const scs_u32_t count = entry.instruction_count;
+	macro.instruction_count = count < static_cast<scs_u32_t>(macroMaxInstructions) ? count : macroMaxInstructions;
+	memcpy(macro.instructions, entry.instructions, sizeof(macro.instructions));
+	macro.active = true;
+	macro.pc = 0;
+	macro.wait_frame = 0;
+	macro.wait_time = 0;
+	macro.release_input = -1;
+
+	entry.sequence.store(head + macroQueueLength, std::memory_order_release);
+	queue.head.store(head + 1, std::memory_order_relaxed);
+	return true;
+}
+
+// Advances one macro until it waits or ends.
+static void step(running_macro_t& macro, const scs_u64_t time)
+{
+	if (frame < macro.wait_frame || time < macro.wait_time) {
+		return;
+	}
+	if (macro.release_input >= 0) {
+		holds[macro.release_input - axisCount]--;
+		macro.release_input = -1;
+		macro.wait_frame = frame + 1;
+		return;
+	}
+
+	while (macro.pc < static_cast<int>(macro.instruction_count))
+	{
+		const macro_instruction_t& instruction = macro.instructions[macro.pc++];
+		const int input = instruction.input;
+
+		switch (instruction.opcode)
+		{
+		case macro_opcode_press:
+		case macro_opcode_release:
+			if (is_button(input)) {
+				pressed[input - axisCount] = instruction.opcode == macro_opcode_press;
+				macro.wait_frame = frame + 1;
+				return;
+			}
+			break;
+		case macro_opcode_hold:
+			if (is_button(input)) {
+				holds[input - axisCount]++;
+				macro.release_input = input;
+				macro.wait_frame = frame + 1;
+				macro.wait_time = time + static_cast<scs_u64_t>(instruction.argument) * 1000;
+				return;
+			}
+			break;
+		case macro_opcode_wait_frames:
+			macro.wait_frame = frame + instruction.argument;
+			return;
+		case macro_opcode_wait_ms:
+			macro.wait_time = time + static_cast<scs_u64_t>(instruction.argument) * 1000;
+			return;
+		default:
+			macro.pc = macro.instruction_count;
+			break;
+		}
+	}
+
+	macro.active = false;
+}
+
+void macro_update(macro_queue_t& queue, const scs_u64_t time, bool* const buttons)
+{
+	frame++;
+
+	scs_u32_t running = 0;
+	scs_u32_t finished = 0;
+	for (int i = 0; i < macroMaxRunning; i++)
+	{
+		running_macro_t& macro = macros[i];
+		if (!macro.active && !dequeue(queue, macro)) {
+			continue;
+		}
+		step(macro, time);
+		if (macro.active) {
+			running++;
+		}
+		else {
+			finished++;
+		}
+	}
+
+	if (finished) {
+		queue.executed.fetch_add(finished, std::memory_order_relaxed);
+	}
+	queue.running.store(running, std::memory_order_relaxed);
+
+	for (int i = 0; i < buttonCount; i++)
+	{
+		buttons[i] = buttons[i] || pressed[i] || holds[i] > 0;
+	}
+}
+
+void macro_reset(macro_queue_t& queue)
+{
+	memset(macros, 0, sizeof(macros));
+	memset(pressed, 0, sizeof(pressed));
+	memset(holds, 0, sizeof(holds));
+	frame = 0;
+	for (int i = 0; i < macroQueueLength; i++)
+	{
+		queue.entries[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,21 @@
+#ifndef INPUT_SEMANTICAL_MACRO_H
+#define INPUT_SEMANTICAL_MACRO_H
+
+#include "control_layout.h"
+
+const int macroMaxRunning = 8;
+
+/**
+ * @brief Runs the macros for one frame.
+ *
+ * Takes newly submitted macros from the queue while there is room, advances
+ * every running macro up to its next wait and presses the buttons the
+ * macros hold on top of the given ones. Every press or release stays in
+ * effect for at least one frame so that short pulses reach the game.
+ */
+void macro_update(macro_queue_t& queue, const scs_u64_t time, bool* const buttons);
+
+// Stops all macros and prepares the queue of a newly created block.
+void macro_reset(macro_queue_t& queue);
+
+#endif // INPUT_SEMANTICAL_MACRO_H
@@ -0,0 +1,640 @@
+#ifdef _WIN32
+#  define WINVER 0x0502
+#  define _WIN32_WINNT 0x0502
+#  include <windows.h>
+#  include <psapi.h>
+#  pragma comment(lib, "psapi.lib")
+#  pragma comment(lib, "advapi32.lib")
+#else
+#  include <errno.h>
+#  include <limits.h>
+#  include <signal.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/resource.h>
+#  include <sys/stat.h>
+#  include <time.h>
+#  include <unistd.h>
+#  ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#  endif
+#endif
+
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef _WIN32
+
+bool shared_memory_create(shared_memory_t& memory, const char* const name, const size_t size)
+{
+	memset(&memory, 0, sizeof(memory));
+
+	HANDLE handle = CreateFileMappingA(
+		INVALID_HANDLE_VALUE,    // use paging file
+		NULL,                    // default security
+		PAGE_READWRITE,          // read/write access
+		0,                       // maximum object size (high-order DWORD)
+		static_cast<DWORD>(size),// maximum object size (low-order DWORD)
+		name);                   // name of mapping object
+	if (handle == NULL) {
+		return false;
+	}
+
+	memory.data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (memory.data == NULL) {
+		CloseHandle(handle);
+		return false;
+	}
+	memory.handle = handle;
+	memory.size = size;
+	return true;
+}
+
+bool shared_memory_attach(shared_memory_t& memory, const char* const name, const size_t size)
+{
+	// The mapping lives as long as somebody holds a handle anyway.
+	return shared_memory_create(memory, name, size);
+}
+
+bool shared_memory_open(shared_memory_t& memory, const char* const name, const size_t size)
+{
+	memset(&memory, 0, sizeof(memory));
+
+	HANDLE handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+	if (handle == NULL) {
+		return false;
+	}
+
+	memory.data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (memory.data == NULL) {
+		CloseHandle(handle);
+		return false;
+	}
+	memory.handle = handle;
+	memory.size = size;
+	return true;
+}
+
+void shared_memory_close(shared_memory_t& memory)
+{
+	if (memory.data) {
+		UnmapViewOfFile(memory.data);
+	}
+	if (memory.handle) {
+		CloseHandle(memory.handle);
+	}
+	memset(&memory, 0, sizeof(memory));
+}
+
+size_t shared_memory_size(const char* const name)
+{
+	HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (handle == NULL) {
+		return 0;
+	}
+
+	// The section size itself is not queryable, a full view spans its pages.
+	size_t size = 0;
+	void* const view = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+	if (view) {
+		MEMORY_BASIC_INFORMATION info;
+		if (VirtualQuery(view, &info, sizeof(info)) == sizeof(info)) {
+			size = info.RegionSize;
+		}
+		UnmapViewOfFile(view);
+	}
+	CloseHandle(handle);
+	return size;
+}
+
+bool shared_event_create(shared_event_t& event, const char* const name)
+{
+	// Manual-reset, so one SetEvent releases every waiter, see shared_event_wait.
+	event.handle = CreateEventA(NULL, TRUE, FALSE, name);
+	return event.handle != NULL;
+}
+
+bool shared_event_open(shared_event_t& event, const char* const name)
+{
+	event.handle = OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name);
+	return event.handle != NULL;
+}
+
+void shared_event_close(shared_event_t& event)
+{
+	if (event.handle) {
+		CloseHandle(event.handle);
+	}
+	event.handle = NULL;
+}
+
+void shared_event_wait(shared_event_t& event, const std::atomic<scs_u32_t>& counter, const scs_u32_t value, const scs_u64_t timeout)
+{
+	if (!event.handle || counter.load(std::memory_order_acquire) != value) {
+		return;
+	}
+	// Round up so short timeouts still block instead of spinning.
+	const DWORD milliseconds = static_cast<DWORD>((timeout + 999) / 1000);
+	if (WaitForSingleObject(event.handle, milliseconds) != WAIT_OBJECT_0 || counter.load(std::memory_order_acquire) != value) {
+		return;
+	}
+	// Still set from an earlier change, which every waiter has seen by now.
+	// The signaller changes the counter before setting the event, so after
+	// the reset either the counter moved or the next SetEvent wakes us.
+	ResetEvent(event.handle);
+	if (counter.load(std::memory_order_acquire) == value) {
+		WaitForSingleObject(event.handle, milliseconds);
+	}
+}
+
+void shared_event_signal(shared_event_t& event, std::atomic<scs_u32_t>& /*counter*/)
+{
+	if (event.handle) {
+		SetEvent(event.handle);
+	}
+}
+
+scs_u64_t monotonic_time_us(void)
+{
+	static LARGE_INTEGER frequency;
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return static_cast<scs_u64_t>(counter.QuadPart / frequency.QuadPart * 1000000 + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
+
+void sleep_us(const scs_u64_t duration)
+{
+	Sleep(static_cast<DWORD>(duration / 1000));
+}
+
+scs_u32_t process_id(void)
+{
+	return GetCurrentProcessId();
+}
+
+bool process_alive(const scs_u32_t id)
+{
+	HANDLE process = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, id);
+	if (process == NULL) {
+		return false;
+	}
+	DWORD code = 0;
+	const BOOL queried = GetExitCodeProcess(process, &code);
+	CloseHandle(process);
+	return queried && code == STILL_ACTIVE;
+}
+
+scs_u64_t file_modification_time(const char* const path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes)) {
+		return 0;
+	}
+	return (static_cast<scs_u64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+long file_read(const char* const path, char* const buffer, const size_t size)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return -1;
+	}
+	DWORD total = 0;
+	DWORD read = 0;
+	while (total < size - 1 && ReadFile(file, buffer + total, static_cast<DWORD>(size - 1 - total), &read, NULL) && read > 0)
+	{
+		total += read;
+	}
+	CloseHandle(file);
+	buffer[total] = '\0';
+	return static_cast<long>(total);
+}
+
+bool file_write(const char* const path, const char* const data, const size_t size)
+{
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	DWORD written = 0;
+	const BOOL result = WriteFile(file, data, static_cast<DWORD>(size), &written, NULL);
+	CloseHandle(file);
+	return result && written == size;
+}
+
+bool file_truncate(const char* const path, const scs_u64_t size)
+{
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER position;
+	position.QuadPart = static_cast<LONGLONG>(size);
+	const BOOL result = SetFilePointerEx(file, position, NULL, FILE_BEGIN) && SetEndOfFile(file);
+	CloseHandle(file);
+	return result != 0;
+}
+
+size_t memory_page_size(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+}
+
+bool memory_lock(void* const data, const size_t size)
+{
+	// VirtualLock is limited by the minimum working set, which is only a few
+	// hundred kilobytes by default.
+	HANDLE process = GetCurrentProcess();
+	SIZE_T minimum = 0;
+	SIZE_T maximum = 0;
+	if (GetProcessWorkingSetSize(process, &minimum, &maximum)) {
+		const SIZE_T grown = minimum + size + memory_page_size();
+		SetProcessWorkingSetSize(process, grown, maximum > grown ? maximum : grown);
+	}
+	return VirtualLock(data, size) != 0;
+}
+
+void memory_unlock(void* const data, const size_t size)
+{
+	VirtualUnlock(data, size);
+}
+
+// Large pages need SeLockMemoryPrivilege held and enabled in the token.
+static bool enable_lock_memory_privilege(void)
+{
+	HANDLE token;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+		return false;
+	}
+	TOKEN_PRIVILEGES privileges;
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+	const bool enabled = LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+		AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL) && GetLastError() == ERROR_SUCCESS;
+	CloseHandle(token);
+	return enabled;
+}
+
+void* memory_allocate(const size_t size, const bool large_pages, bool& large)
+{
+	large = false;
+	const SIZE_T large_size = GetLargePageMinimum();
+	if (large_pages && large_size != 0 && enable_lock_memory_privilege()) {
+		const SIZE_T rounded = (size + large_size - 1) / large_size * large_size;
+		void* const data = VirtualAlloc(NULL, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (data) {
+			large = true;
+			return data;
+		}
+	}
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void memory_free(void* const data, const size_t /*size*/, const bool /*large*/)
+{
+	if (data) {
+		VirtualFree(data, 0, MEM_RELEASE);
+	}
+}
+
+scs_u64_t page_fault_count(void)
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	counters.cb = sizeof(counters);
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return 0;
+	}
+	return counters.PageFaultCount;
+}
+
+#else
+
+static void posix_name(const char* const name, char* const result, const size_t result_size)
+{
+	const char prefix[] = "Local\\";
+	const char* base = name;
+	if (strncmp(name, prefix, sizeof(prefix) - 1) == 0) {
+		base += sizeof(prefix) - 1;
+	}
+	result[0] = '/';
+	strncpy(result + 1, base, result_size - 2);
+	result[result_size - 1] = '\0';
+}
+
+static bool shared_memory_map(shared_memory_t& memory, const int fd, const size_t size)
+{
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		return false;
+	}
+	if (static_cast<size_t>(info.st_size) < size && ftruncate(fd, size) != 0) {
+		return false;
+	}
+
+	void* const data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	memory.data = data;
+	memory.size = size;
+	memory.fd = fd;
+	return true;
+}
+
+bool shared_memory_create(shared_memory_t& memory, const char* const name, const size_t size)
+{
+	memset(&memory, 0, sizeof(memory));
+	memory.fd = -1;
+	posix_name(name, memory.name, sizeof(memory.name));
+
+	// Only the process which really created the object removes it again,
+	// an existing one belongs to whoever made it.
+	int fd = shm_open(memory.name, O_RDWR | O_CREAT | O_EXCL, 0666);
+	const bool created = fd >= 0;
+	if (!created && errno == EEXIST) {
+		fd = shm_open(memory.name, O_RDWR, 0666);
+	}
+	if (fd < 0) {
+		return false;
+	}
+	if (!shared_memory_map(memory, fd, size)) {
+		close(fd);
+		memory.fd = -1;
+		return false;
+	}
+	memory.owner = created;
+	return true;
+}
+
+bool shared_memory_attach(shared_memory_t& memory, const char* const name, const size_t size)
+{
+	if (!shared_memory_create(memory, name, size)) {
+		return false;
+	}
+	memory.owner = false;
+	return true;
+}
+
+bool shared_memory_open(shared_memory_t& memory, const char* const name, const size_t size)
+{
+	memset(&memory, 0, sizeof(memory));
+	memory.fd = -1;
+	posix_name(name, memory.name, sizeof(memory.name));
+
+	const int fd = shm_open(memory.name, O_RDWR, 0666);
+	if (fd < 0) {
+		return false;
+	}
+	if (!shared_memory_map(memory, fd, size)) {
+		close(fd);
+		memory.fd = -1;
+		return false;
+	}
+	return true;
+}
+
+void shared_memory_close(shared_memory_t& memory)
+{
+	if (memory.data) {
+		munmap(memory.data, memory.size);
+	}
+	if (memory.fd >= 0) {
+		close(memory.fd);
+	}
+	// Windows drops the mapping with its last handle, POSIX needs an explicit
+	// unlink by whoever created it.
+	if (memory.owner) {
+		shm_unlink(memory.name);
+	}
+	memset(&memory, 0, sizeof(memory));
+	memory.fd = -1;
+}
+
+size_t shared_memory_size(const char* const name)
+{
+	char path[256];
+	posix_name(name, path, sizeof(path));
+	const int fd = shm_open(path, O_RDONLY, 0);
+	if (fd < 0) {
+		return 0;
+	}
+	struct stat info;
+	const size_t size = fstat(fd, &info) == 0 ? static_cast<size_t>(info.st_size) : 0;
+	close(fd);
+	return size;
+}
+
+bool shared_event_create(shared_event_t& event, const char* const /*name*/)
+{
+	event.handle = NULL;
+	return true;
+}
+
+bool shared_event_open(shared_event_t& event, const char* const /*name*/)
+{
+	event.handle = NULL;
+	return true;
+}
+
+void shared_event_close(shared_event_t& event)
+{
+	event.handle = NULL;
+}
+
+void shared_event_wait(shared_event_t& /*event*/, const std::atomic<scs_u32_t>& counter, const scs_u32_t value, const scs_u64_t timeout)
+{
+#ifdef __linux__
+	// Shared (not FUTEX_PRIVATE) futex as the counter is mapped by several processes.
+	struct timespec relative;
+	relative.tv_sec = static_cast<time_t>(timeout / 1000000);
+	relative.tv_nsec = static_cast<long>(timeout % 1000000) * 1000;
+	syscall(SYS_futex, reinterpret_cast<const scs_u32_t*>(&counter), FUTEX_WAIT, value, &relative, NULL, 0);
+#else
+	if (counter.load(std::memory_order_acquire) == value) {
+		sleep_us(timeout < 100 ? timeout : 100);
+	}
+#endif
+}
+
+void shared_event_signal(shared_event_t& /*event*/, std::atomic<scs_u32_t>& counter)
+{
+#ifdef __linux__
+	syscall(SYS_futex, reinterpret_cast<scs_u32_t*>(&counter), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+	(void)counter;
+#endif
+}
+
+scs_u64_t monotonic_time_us(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<scs_u64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+void sleep_us(const scs_u64_t duration)
+{
+	usleep(static_cast<useconds_t>(duration));
+}
+
+scs_u32_t process_id(void)
+{
+	return static_cast<scs_u32_t>(getpid());
+}
+
+bool process_alive(const scs_u32_t id)
+{
+	// EPERM means the process exists but belongs to somebody else.
+	return id != 0 && (kill(static_cast<pid_t>(id), 0) == 0 || errno == EPERM);
+}
+
+scs_u64_t file_modification_time(const char* const path)
+{
+	struct stat status;
+	if (stat(path, &status) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	const struct timespec& modified = status.st_mtimespec;
+#else
+	const struct timespec& modified = status.st_mtim;
+#endif
+	return static_cast<scs_u64_t>(modified.tv_sec) * 1000000000 + modified.tv_nsec;
+}
+
+long file_read(const char* const path, char* const buffer, const size_t size)
+{
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	size_t total = 0;
+	ssize_t count;
+	while (total < size - 1 && (count = read(fd, buffer + total, size - 1 - total)) > 0)
+	{
+		total += count;
+	}
+	close(fd);
+	buffer[total] = '\0';
+	return static_cast<long>(total);
+}
+
+bool file_write(const char* const path, const char* const data, const size_t size)
+{
+	const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	size_t total = 0;
+	ssize_t count;
+	while (total < size && (count = write(fd, data + total, size - total)) > 0)
+	{
+		total += count;
+	}
+	close(fd);
+	return total == size;
+}
+
+bool file_truncate(const char* const path, const scs_u64_t size)
+{
+	return truncate(path, static_cast<off_t>(size)) == 0;
+}
+
+size_t memory_page_size(void)
+{
+	return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+bool memory_lock(void* const data, const size_t size)
+{
+	return mlock(data, size) == 0;
+}
+
+void memory_unlock(void* const data, const size_t size)
+{
+	munlock(data, size);
+}
+
+// Size of the huge pages MAP_HUGETLB hands out by default.
+static const size_t hugePageSize = 2 * 1024 * 1024;
+
+void* memory_allocate(const size_t size, const bool large_pages, bool& large)
+{
+	large = false;
+#ifdef MAP_HUGETLB
+	if (large_pages) {
+		const size_t rounded = (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+		void* const data = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (data != MAP_FAILED) {
+			large = true;
+			return data;
+		}
+	}
+#else
+	(void)large_pages;
+#endif
+	void* const data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+#ifdef MADV_HUGEPAGE
+	// Without reserved huge pages transparent ones may still back the range.
+	if (large_pages) {
+		madvise(data, size, MADV_HUGEPAGE);
+	}
+#endif
+	return data;
+}
+
+void memory_free(void* const data, const size_t size, const bool large)
+{
+	if (!data) {
+		return;
+	}
+	munmap(data, large ? (size + hugePageSize - 1) / hugePageSize * hugePageSize : size);
+}
+
+scs_u64_t page_fault_count(void)
+{
+	struct rusage usage;
+#ifdef RUSAGE_THREAD
+	if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+		return 0;
+	}
+#else
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#endif
+	return static_cast<scs_u64_t>(usage.ru_minflt) + static_cast<scs_u64_t>(usage.ru_majflt);
+}
+
+#endif
+
+size_t memory_prefault(void* const data, const size_t size)
+{
+	if (!data || size == 0) {
+		return 0;
+	}
+	const size_t page = memory_page_size();
+	volatile char* const bytes = static_cast<volatile char*>(data);
+	size_t pages = 0;
+	for (size_t offset = 0; offset < size; offset += page)
+	{
+		bytes[offset] = bytes[offset];
+		pages++;
+	}
+	// The last page when the range does not start on a page boundary.
+	if ((reinterpret_cast<size_t>(data) + size - 1) / page != (reinterpret_cast<size_t>(data) + (pages - 1) * page) / page) {
+		bytes[size - 1] = bytes[size - 1];
+		pages++;
+	}
+	return pages;
+}
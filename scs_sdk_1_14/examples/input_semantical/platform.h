@@ -0,0 +1,116 @@
+#ifndef INPUT_SEMANTICAL_PLATFORM_H
+#define INPUT_SEMANTICAL_PLATFORM_H
+
+#include <stddef.h>
+#include <atomic>
+
+#include "scssdk.h"
+
+/**
+ * @brief Named shared memory mapping.
+ *
+ * Names use the Windows form ("Local\\SCSControls"). On other systems the
+ * "Local\\" prefix is replaced by "/" and the POSIX shm_open namespace is used.
+ */
+struct shared_memory_t
+{
+	void* data;
+	size_t size;
+#ifdef _WIN32
+	void* handle;
+#else
+	int fd;
+	bool owner;
+	char name[256];
+#endif
+};
+
+// Creates the mapping or attaches to an existing one of the same name. On
+// POSIX the name is removed on close when this call created the object.
+bool shared_memory_create(shared_memory_t& memory, const char* const name, const size_t size);
+
+// Like shared_memory_create but the mapping is never removed on close, for
+// blocks shared by several plugin instances which come and go.
+bool shared_memory_attach(shared_memory_t& memory, const char* const name, const size_t size);
+
+// Attaches to an existing mapping, fails if nobody created it yet.
+bool shared_memory_open(shared_memory_t& memory, const char* const name, const size_t size);
+
+void shared_memory_close(shared_memory_t& memory);
+
+// Size of an existing mapping, in whole pages on Windows, 0 without one.
+size_t shared_memory_size(const char* const name);
+
+/**
+ * @brief Wakeup channel for a 32 bit counter living in shared memory.
+ *
+ * On Linux the counter itself is used as a futex and the handle is unused.
+ * On Windows a named manual-reset event accompanies the counter, set after
+ * every change so all waiters wake up, and reset by the first waiter which
+ * finds it set while the counter still holds the value it waits on. Waiters
+ * always re-check the counter, so a stale or missed signal only costs a
+ * wakeup or at worst the timeout.
+ */
+struct shared_event_t
+{
+	void* handle;
+};
+
+bool shared_event_create(shared_event_t& event, const char* const name);
+bool shared_event_open(shared_event_t& event, const char* const name);
+void shared_event_close(shared_event_t& event);
+
+// Blocks while *counter equals value, for at most timeout microseconds.
+void shared_event_wait(shared_event_t& event, const std::atomic<scs_u32_t>& counter, const scs_u32_t value, const scs_u64_t timeout);
+
+// Wakes everybody waiting on the counter, call it after changing the counter.
+void shared_event_signal(shared_event_t& event, std::atomic<scs_u32_t>& counter);
+
+// Monotonic time shared by all processes on the machine.
+scs_u64_t monotonic_time_us(void);
+
+void sleep_us(const scs_u64_t duration);
+
+scs_u32_t process_id(void);
+
+// False once the process exited, also when it can not be queried.
+bool process_alive(const scs_u32_t id);
+
+// Opaque last write time of a file which changes with every write, 0 when
+// the file does not exist.
+scs_u64_t file_modification_time(const char* const path);
+
+// Reads at most size - 1 bytes of a file and terminates them. Returns the
+// number of bytes read or -1 when the file can not be opened. Goes straight
+// to the system without stdio, so it never allocates and can be used from
+// the callbacks.
+long file_read(const char* const path, char* const buffer, const size_t size);
+
+// Replaces the contents of a file, without stdio like file_read.
+bool file_write(const char* const path, const char* const data, const size_t size);
+
+// Cuts a file off after size bytes.
+bool file_truncate(const char* const path, const scs_u64_t size);
+
+size_t memory_page_size(void);
+
+// Touches every page of a range, writing back what it reads, so the first
+// access from a callback does not fault. Returns the number of pages.
+size_t memory_prefault(void* const data, const size_t size);
+
+// Keeps the pages of a range in memory (mlock, VirtualLock after growing the
+// working set). Fails when the system limit for locked memory is reached.
+bool memory_lock(void* const data, const size_t size);
+void memory_unlock(void* const data, const size_t size);
+
+// Allocates zeroed pages, with large_pages from huge (Linux) or large
+// (Windows, needs the "Lock pages in memory" right) pages when the system
+// has them. large tells whether it did, and has to be passed to memory_free.
+void* memory_allocate(const size_t size, const bool large_pages, bool& large);
+void memory_free(void* const data, const size_t size, const bool large);
+
+// Page faults so far of the calling thread, of the whole process on Windows
+// and macOS.
+scs_u64_t page_fault_count(void);
+
+#endif // INPUT_SEMANTICAL_PLATFORM_H
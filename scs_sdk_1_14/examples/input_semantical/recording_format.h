@@ -0,0 +1,119 @@
+/**
+ * @brief On-disk format of the telemetry recordings.
+ *
+ * A recording is a file header followed by self-contained chunks. Every
+ * chunk carries a footer with per-channel min/max and a sparse index of
+ * simulation time to file offset so readers can skip whole chunks or seek
+ * straight to the start of a time window without touching the samples.
+ *
+ *   recording_file_header_t
+ *   chunk 0: recording_chunk_header_t, samples, recording_chunk_footer_t
+ *   chunk 1: ...
+ *
+ * Samples are a u64 simulation timestamp (microseconds) followed by
+ * channel_count floats. All values are little endian.
+ */
+#ifndef INPUT_SEMANTICAL_RECORDING_FORMAT_H
+#define INPUT_SEMANTICAL_RECORDING_FORMAT_H
+
+#include "scssdk.h"
+
+const scs_u32_t recordingVersion = 1;
+const char recordingMagic[8] = { 'S', 'C', 'S', 'R', 'E', 'C', '1', '\0' };
+const scs_u32_t recordingChunkMagic = 0x4b4e4843;	// "CHNK"
+const scs_u32_t recordingFooterMagic = 0x58444e49;	// "INDX"
+
+const int recordingMaxChannels = 32;
+const int recordingChannelNameSize = 32;
+const int recordingChunkSamples = 4096;
+const int recordingIndexStride = 64;
+const int recordingIndexEntries = recordingChunkSamples / recordingIndexStride;
+
+// Channels written by the plugin, in sample order.
+enum recording_channel_t
+{
+	recording_channel_speed,
+	recording_channel_steering,
+	recording_channel_throttle,
+	recording_channel_brake,
+	recording_channel_clutch,
+	recording_channel_effective_steering,
+	recording_channel_effective_throttle,
+	recording_channel_effective_brake,
+	recording_channel_effective_clutch,
+	recording_channel_rpm,
+	recording_channel_gear,
+	recording_channel_x,
+	recording_channel_y,
+	recording_channel_z,
+	recording_channel_heading,
+	recording_channel_game_time,
+	recording_channel_count
+};
+
+const char* const recordingChannelNames[recording_channel_count] = {
+	"speed",		// m/s
+	"steering",		// truck.input.steering
+	"throttle",
+	"brake",
+	"clutch",
+	"effective_steering",
+	"effective_throttle",
+	"effective_brake",
+	"effective_clutch",
+	"rpm",
+	"gear",
+	"x",
+	"y",
+	"z",
+	"heading",		// <0,1) turns
+	"game_time"		// in-game minutes
+};
+
+#pragma pack(push, 1)
+
+struct recording_file_header_t
+{
+	char magic[8];
+	scs_u32_t version;
+	scs_u32_t channel_count;
+	scs_u32_t chunk_samples;
+	scs_u32_t index_stride;
+	scs_s64_t start_unix_time;
+	char channel_names[recordingMaxChannels][recordingChannelNameSize];
+};
+
+struct recording_chunk_header_t
+{
+	scs_u32_t magic;
+	scs_u32_t sample_count;
+	scs_u64_t first_time;
+	scs_u64_t last_time;
+	scs_u64_t footer_offset;	// Absolute file offset of the footer.
+	scs_u64_t next_offset;		// Absolute file offset of the next chunk.
+};
+
+struct recording_index_entry_t
+{
+	scs_u64_t time;
+	scs_u64_t offset;		// Absolute file offset of the sample.
+};
+
+struct recording_chunk_footer_t
+{
+	scs_u32_t magic;
+	scs_u32_t index_count;
+	float minimum[recordingMaxChannels];
+	float maximum[recordingMaxChannels];
+	recording_index_entry_t index[recordingIndexEntries];
+};
+
+struct recording_sample_t
+{
+	scs_u64_t time;
+	float values[recording_channel_count];
+};
+
+#pragma pack(pop)
+
+#endif // INPUT_SEMANTICAL_RECORDING_FORMAT_H
@@ -0,0 +1,79 @@
+#include <math.h>
+
+#include "response_curve.h"
+
+static float clamp(const float value, const float minimum, const float maximum)
+{
+	return value < minimum ? minimum : (value > maximum ? maximum : value);
+}
+
+void curve_default(curve_params_t& params)
+{
+	params.deadzone = 0.0f;
+	params.saturation = 1.0f;
+	params.expo = 0.0f;
+	params.point_count = 0;
+}
+
+// Piecewise linear interpolation through the points, held past both ends.
+static float curve_points(const curve_params_t& params, const float x)
+{
+	const int count = params.point_count < curveMaxPoints ? params.point_count : curveMaxPoints;
+	if (x <= params.points[0][0]) {
+		return params.points[0][1];
+	}
+	for (int i = 1; i < count; i++)
+	{
+		if (x <= params.points[i][0]) {
+			const float span = params.points[i][0] - params.points[i - 1][0];
+			const float t = span > 0.0f ? (x - params.points[i - 1][0]) / span : 1.0f;
+			return params.points[i - 1][1] + (params.points[i][1] - params.points[i - 1][1]) * t;
+		}
+	}
+	return params.points[count - 1][1];
+}
+
+void curve_compile(const curve_params_t& params, curve_table_t& table)
+{
+	const float deadzone = clamp(params.deadzone, 0.0f, 1.0f);
+	const float saturation = clamp(params.saturation, deadzone, 1.0f);
+	const float expo = clamp(params.expo, 0.0f, 1.0f);
+
+	for (int i = 0; i <= curveTableSegments; i++)
+	{
+		const float x = static_cast<float>(i) / curveTableSegments;
+
+		float y;
+		if (x <= deadzone) {
+			y = 0.0f;
+		}
+		else if (x >= saturation) {
+			y = 1.0f;
+		}
+		else {
+			y = (x - deadzone) / (saturation - deadzone);
+		}
+
+		y = (1.0f - expo) * y + expo * y * y * y;
+
+		if (params.point_count > 0) {
+			y = curve_points(params, y);
+		}
+
+		table.values[i] = clamp(y, 0.0f, 1.0f);
+	}
+	table.values[curveTableSegments + 1] = table.values[curveTableSegments];
+}
+
+void curve_apply(const curve_table_t* const tables, float* const values, const int count)
+{
+	// Kept free of branches so the compiler can vectorise it across axes.
+	for (int axis = 0; axis < count; axis++)
+	{
+		const float magnitude = fminf(fabsf(values[axis]), 1.0f) * curveTableSegments;
+		const int index = static_cast<int>(magnitude);
+		const float fraction = magnitude - static_cast<float>(index);
+		const float* const entry = tables[axis].values + index;
+		values[axis] = copysignf(entry[0] + (entry[1] - entry[0]) * fraction, values[axis]);
+	}
+}
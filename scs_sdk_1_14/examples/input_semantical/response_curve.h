@@ -0,0 +1,44 @@
+/**
+ * @brief Axis response curves.
+ *
+ * A curve is described by a deadzone, a saturation point, an expo factor and
+ * optional piecewise linear points, all applied to the magnitude of the axis
+ * value so that the curve is symmetric around zero. At load time every curve
+ * is compiled into a lookup table which the hot path interpolates without
+ * branches.
+ */
+#ifndef INPUT_SEMANTICAL_RESPONSE_CURVE_H
+#define INPUT_SEMANTICAL_RESPONSE_CURVE_H
+
+const int curveTableSegments = 64;
+const int curveMaxPoints = 8;
+
+struct curve_params_t
+{
+	float deadzone;		// magnitude below which the output is zero
+	float saturation;	// magnitude at which the output reaches one
+	float expo;		// <0,1> blend between linear and cubic response
+	int point_count;	// 0 = no piecewise curve
+	float points[curveMaxPoints][2];	// (input, output) magnitudes, ascending input
+};
+
+struct curve_table_t
+{
+	// One extra entry so that an input of exactly one interpolates to the
+	// last value without clamping the index.
+	float values[curveTableSegments + 2];
+};
+
+// Identity response: no deadzone, saturation at one, no expo, no points.
+void curve_default(curve_params_t& params);
+
+void curve_compile(const curve_params_t& params, curve_table_t& table);
+
+/**
+ * @brief Applies one table per value in place.
+ *
+ * Values are expected in <-1,1>, anything outside is treated as +-1.
+ */
+void curve_apply(const curve_table_t* const tables, float* const values, const int count);
+
+#endif // INPUT_SEMANTICAL_RESPONSE_CURVE_H
@@ -0,0 +1,427 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rule_vm.h"
+
+enum rule_opcode_t
+{
+	rule_opcode_constant,
+	rule_opcode_float_field,
+	rule_opcode_u32_field,
+	rule_opcode_s32_field,
+	rule_opcode_input,
+	rule_opcode_add,
+	rule_opcode_subtract,
+	rule_opcode_multiply,
+	rule_opcode_divide,
+	rule_opcode_modulo,
+	rule_opcode_less,
+	rule_opcode_less_equal,
+	rule_opcode_greater,
+	rule_opcode_greater_equal,
+	rule_opcode_equal,
+	rule_opcode_not_equal,
+	rule_opcode_and,
+	rule_opcode_or,
+	rule_opcode_not,
+	rule_opcode_negate,
+	rule_opcode_abs,
+	rule_opcode_min,
+	rule_opcode_max
+};
+
+struct rule_field_t
+{
+	const char* name;
+	scs_u8_t opcode;
+	size_t offset;
+};
+
+const rule_field_t ruleFields[] = {
+	{ "speed", rule_opcode_float_field, offsetof(telemetry_state_t, speed) },
+	{ "input_steering", rule_opcode_float_field, offsetof(telemetry_state_t, input_steering) },
+	{ "input_throttle", rule_opcode_float_field, offsetof(telemetry_state_t, input_throttle) },
+	{ "input_brake", rule_opcode_float_field, offsetof(telemetry_state_t, input_brake) },
+	{ "input_clutch", rule_opcode_float_field, offsetof(telemetry_state_t, input_clutch) },
+	{ "effective_steering", rule_opcode_float_field, offsetof(telemetry_state_t, effective_steering) },
+	{ "effective_throttle", rule_opcode_float_field, offsetof(telemetry_state_t, effective_throttle) },
+	{ "effective_brake", rule_opcode_float_field, offsetof(telemetry_state_t, effective_brake) },
+	{ "effective_clutch", rule_opcode_float_field, offsetof(telemetry_state_t, effective_clutch) },
+	{ "rpm", rule_opcode_float_field, offsetof(telemetry_state_t, engine_rpm) },
+	{ "gear", rule_opcode_s32_field, offsetof(telemetry_state_t, engine_gear) },
+	{ "game_time", rule_opcode_u32_field, offsetof(telemetry_state_t, game_time) }	// minutes since the game start
+};
+
+const int ruleFieldCount = sizeof(ruleFields) / sizeof(ruleFields[0]);
+
+// Recursive descent compiler emitting the code while parsing.
+struct rule_compiler_t
+{
+	const char* text;
+	rule_t* rule;
+	const scs_input_device_input_t* inputs;
+	int depth;
+	bool failed;
+	char* error;
+	size_t error_size;
+};
+
+static void fail(rule_compiler_t& compiler, const char* const message)
+{
+	if (!compiler.failed) {
+		snprintf(compiler.error, compiler.error_size, "%s at \"%.20s\"", message, compiler.text);
+		compiler.failed = true;
+	}
+}
+
+// Emits an instruction taking inputs values from the stack and pushing one.
+static void emit(rule_compiler_t& compiler, const scs_u8_t opcode, const int inputs, const scs_u16_t operand = 0, const float constant = 0.0f)
+{
+	if (compiler.failed) {
+		return;
+	}
+	if (compiler.rule->length == ruleMaxCode) {
+		fail(compiler, "expression too long");
+		return;
+	}
+	compiler.depth += 1 - inputs;
+	if (compiler.depth > ruleMaxStack) {
+		fail(compiler, "expression too deep");
+		return;
+	}
+	rule_instruction_t& instruction = compiler.rule->code[compiler.rule->length++];
+	instruction.opcode = opcode;
+	instruction._padding = 0;
+	instruction.operand = operand;
+	instruction.constant = constant;
+}
+
+static void skip_space(rule_compiler_t& compiler)
+{
+	while (isspace(static_cast<unsigned char>(*compiler.text))) {
+		compiler.text++;
+	}
+}
+
+static bool accept(rule_compiler_t& compiler, const char* const token)
+{
+	skip_space(compiler);
+	const size_t length = strlen(token);
+	if (strncmp(compiler.text, token, length) != 0) {
+		return false;
+	}
+	// Do not take "<" out of "<=" and similar.
+	if (length == 1 && (token[0] == '<' || token[0] == '>' || token[0] == '!') && compiler.text[1] == '=') {
+		return false;
+	}
+	compiler.text += length;
+	return true;
+}
+
+static void parse_or(rule_compiler_t& compiler);
+
+static void parse_primary(rule_compiler_t& compiler)
+{
+	skip_space(compiler);
+
+	if (accept(compiler, "(")) {
+		parse_or(compiler);
+		if (!accept(compiler, ")")) {
+			fail(compiler, "missing )");
+		}
+		return;
+	}
+
+	if (isdigit(static_cast<unsigned char>(*compiler.text)) || *compiler.text == '.') {
+		char* end;
+		const float value = static_cast<float>(strtod(compiler.text, &end));
+		compiler.text = end;
+		emit(compiler, rule_opcode_constant, 0, 0, value);
+		return;
+	}
+
+	char name[64];
+	int length = 0;
+	while ((isalnum(static_cast<unsigned char>(*compiler.text)) || *compiler.text == '_') && length < 63)
+	{
+		name[length++] = *compiler.text++;
+	}
+	name[length] = '\0';
+	if (length == 0) {
+		fail(compiler, "expected a value");
+		return;
+	}
+
+	if (strcmp(name, "abs") == 0 || strcmp(name, "min") == 0 || strcmp(name, "max") == 0) {
+		const int arguments = name[0] == 'a' ? 1 : 2;
+		if (!accept(compiler, "(")) {
+			fail(compiler, "missing (");
+			return;
+		}
+		parse_or(compiler);
+		if (arguments == 2 && !accept(compiler, ",")) {
+			fail(compiler, "missing ,");
+			return;
+		}
+		if (arguments == 2) {
+			parse_or(compiler);
+		}
+		if (!accept(compiler, ")")) {
+			fail(compiler, "missing )");
+			return;
+		}
+		emit(compiler, name[0] == 'a' ? rule_opcode_abs : (name[1] == 'i' ? rule_opcode_min : rule_opcode_max), arguments);
+		return;
+	}
+
+	for (int i = 0; i < ruleFieldCount; i++)
+	{
+		if (strcmp(ruleFields[i].name, name) == 0) {
+			emit(compiler, ruleFields[i].opcode, 0, static_cast<scs_u16_t>(ruleFields[i].offset));
+			return;
+		}
+	}
+	for (int i = 0; i < inputCount; i++)
+	{
+		if (strcmp(compiler.inputs[i].name, name) == 0) {
+			emit(compiler, rule_opcode_input, 0, static_cast<scs_u16_t>(i));
+			return;
+		}
+	}
+	fail(compiler, "unknown name");
+}
+
+static void parse_unary(rule_compiler_t& compiler)
+{
+	if (accept(compiler, "!")) {
+		parse_unary(compiler);
+		emit(compiler, rule_opcode_not, 1);
+	}
+	else if (accept(compiler, "-")) {
+		parse_unary(compiler);
+		emit(compiler, rule_opcode_negate, 1);
+	}
+	else {
+		parse_primary(compiler);
+	}
+}
+
+static void parse_product(rule_compiler_t& compiler)
+{
+	parse_unary(compiler);
+	while (!compiler.failed)
+	{
+		scs_u8_t opcode;
+		if (accept(compiler, "*")) {
+			opcode = rule_opcode_multiply;
+		}
+		else if (accept(compiler, "/")) {
+			opcode = rule_opcode_divide;
+		}
+		else if (accept(compiler, "%")) {
+			opcode = rule_opcode_modulo;
+		}
+		else {
+			return;
+		}
+		parse_unary(compiler);
+		emit(compiler, opcode, 2);
+	}
+}
+
+static void parse_sum(rule_compiler_t& compiler)
+{
+	parse_product(compiler);
+	while (!compiler.failed)
+	{
+		scs_u8_t opcode;
+		if (accept(compiler, "+")) {
+			opcode = rule_opcode_add;
+		}
+		else if (accept(compiler, "-")) {
+			opcode = rule_opcode_subtract;
+		}
+		else {
+			return;
+		}
+		parse_product(compiler);
+		emit(compiler, opcode, 2);
+	}
+}
+
+static void parse_comparison(rule_compiler_t& compiler)
+{
+	parse_sum(compiler);
+
+	scs_u8_t opcode;
+	if (accept(compiler, "<=")) {
+		opcode = rule_opcode_less_equal;
+	}
+	else if (accept(compiler, ">=")) {
+		opcode = rule_opcode_greater_equal;
+	}
+	else if (accept(compiler, "==")) {
+		opcode = rule_opcode_equal;
+	}
+	else if (accept(compiler, "!=")) {
+		opcode = rule_opcode_not_equal;
+	}
+	else if (accept(compiler, "<")) {
+		opcode = rule_opcode_less;
+	}
+	else if (accept(compiler, ">")) {
+		opcode = rule_opcode_greater;
+	}
+	else {
+		return;
+	}
+	parse_sum(compiler);
+	emit(compiler, opcode, 2);
+}
+
+static void parse_and(rule_compiler_t& compiler)
+{
+	parse_comparison(compiler);
+	while (!compiler.failed && accept(compiler, "&&"))
+	{
+		parse_comparison(compiler);
+		emit(compiler, rule_opcode_and, 2);
+	}
+}
+
+static void parse_or(rule_compiler_t& compiler)
+{
+	parse_and(compiler);
+	while (!compiler.failed && accept(compiler, "||"))
+	{
+		parse_and(compiler);
+		emit(compiler, rule_opcode_or, 2);
+	}
+}
+
+bool rule_compile(const char* const text, const int target, rule_t& rule, const scs_input_device_input_t* const inputs, char* const error, const size_t error_size)
+{
+	rule.target = target;
+	rule.length = 0;
+
+	rule_compiler_t compiler;
+	compiler.text = text;
+	compiler.rule = &rule;
+	compiler.inputs = inputs;
+	compiler.depth = 0;
+	compiler.failed = false;
+	compiler.error = error;
+	compiler.error_size = error_size;
+
+	parse_or(compiler);
+	skip_space(compiler);
+	if (*compiler.text) {
+		fail(compiler, "unexpected text");
+	}
+	return !compiler.failed;
+}
+
+static float evaluate(const rule_t& rule, const telemetry_state_t& state, const float* const inputs)
+{
+	float stack[ruleMaxStack];
+	int top = -1;
+	const char* const fields = reinterpret_cast<const char*>(&state);
+
+	for (int pc = 0; pc < rule.length; pc++)
+	{
+		const rule_instruction_t& instruction = rule.code[pc];
+		switch (instruction.opcode)
+		{
+		case rule_opcode_constant:
+			stack[++top] = instruction.constant;
+			break;
+		case rule_opcode_float_field:
+			stack[++top] = *reinterpret_cast<const float*>(fields + instruction.operand);
+			break;
+		case rule_opcode_u32_field:
+			stack[++top] = static_cast<float>(*reinterpret_cast<const scs_u32_t*>(fields + instruction.operand));
+			break;
+		case rule_opcode_s32_field:
+			stack[++top] = static_cast<float>(*reinterpret_cast<const scs_s32_t*>(fields + instruction.operand));
+			break;
+		case rule_opcode_input:
+			stack[++top] = inputs[instruction.operand];
+			break;
+		case rule_opcode_not:
+			stack[top] = stack[top] == 0.0f ? 1.0f : 0.0f;
+			break;
+		case rule_opcode_negate:
+			stack[top] = -stack[top];
+			break;
+		case rule_opcode_abs:
+			stack[top] = fabsf(stack[top]);
+			break;
+		default:
+		{
+			const float b = stack[top--];
+			const float a = stack[top];
+			float result;
+			switch (instruction.opcode)
+			{
+			case rule_opcode_add: result = a + b; break;
+			case rule_opcode_subtract: result = a - b; break;
+			case rule_opcode_multiply: result = a * b; break;
+			case rule_opcode_divide: result = b != 0.0f ? a / b : 0.0f; break;
+			case rule_opcode_modulo: result = b != 0.0f ? fmodf(a, b) : 0.0f; break;
+			case rule_opcode_less: result = a < b; break;
+			case rule_opcode_less_equal: result = a <= b; break;
+			case rule_opcode_greater: result = a > b; break;
+			case rule_opcode_greater_equal: result = a >= b; break;
+			case rule_opcode_equal: result = a == b; break;
+			case rule_opcode_not_equal: result = a != b; break;
+			case rule_opcode_and: result = (a != 0.0f && b != 0.0f); break;
+			case rule_opcode_or: result = (a != 0.0f || b != 0.0f); break;
+			case rule_opcode_min: result = a < b ? a : b; break;
+			case rule_opcode_max: result = a > b ? a : b; break;
+			default: result = 0.0f; break;
+			}
+			stack[top] = result;
+			break;
+		}
+		}
+	}
+	return top >= 0 ? stack[top] : 0.0f;
+}
+
+void rule_run(const rule_set_t& rules, const telemetry_state_t& state, float* const axes, bool* const buttons)
+{
+	if (rules.count == 0) {
+		return;
+	}
+
+	float inputs[inputCount];
+	for (int i = 0; i < axisCount; i++)
+	{
+		inputs[i] = axes[i];
+	}
+	for (int i = 0; i < buttonCount; i++)
+	{
+		inputs[axisCount + i] = buttons[i] ? 1.0f : 0.0f;
+	}
+
+	int budget = ruleFrameBudget;
+	for (int i = 0; i < rules.count; i++)
+	{
+		const rule_t& rule = rules.rules[i];
+		budget -= rule.length;
+		if (budget < 0) {
+			break;
+		}
+
+		const float value = evaluate(rule, state, inputs);
+		if (rule.target < axisCount) {
+			axes[rule.target] = value;
+		}
+		else {
+			buttons[rule.target - axisCount] = buttons[rule.target - axisCount] || value != 0.0f;
+		}
+	}
+}
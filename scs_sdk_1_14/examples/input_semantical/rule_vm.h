@@ -0,0 +1,65 @@
+/**
+ * @brief Rules evaluated by the plugin every frame.
+ *
+ * A rule sets one input from an expression over telemetry fields and the
+ * values of the inputs, e.g. "flasher4way = speed > 20 && effective_brake >
+ * 0.8". Expressions know numbers, the operators + - * / % < <= > >= == !=
+ * && || ! and unary -, parentheses and the functions abs, min and max. They
+ * are compiled when the configuration loads into a small stack bytecode with
+ * field offsets resolved, so evaluation does not allocate or look anything
+ * up by name.
+ */
+#ifndef INPUT_SEMANTICAL_RULE_VM_H
+#define INPUT_SEMANTICAL_RULE_VM_H
+
+#include <stddef.h>
+
+#include "control_layout.h"
+#include "telemetry.h"
+
+#include "scssdk_input.h"
+
+const int ruleMaxCount = 16;
+const int ruleMaxCode = 64;
+const int ruleMaxStack = 16;
+const int ruleFrameBudget = 512;	// instructions per frame over all rules
+
+struct rule_instruction_t
+{
+	scs_u8_t opcode;
+	scs_u8_t _padding;
+	scs_u16_t operand;		// field offset or input index
+	float constant;
+};
+
+struct rule_t
+{
+	int target;			// input index
+	int length;
+	rule_instruction_t code[ruleMaxCode];
+};
+
+struct rule_set_t
+{
+	int count;
+	rule_t rules[ruleMaxCount];
+};
+
+/**
+ * @brief Compiles the expression of one rule.
+ *
+ * Returns false and describes the problem in error when the expression is
+ * malformed, uses an unknown name or does not fit into the limits.
+ */
+bool rule_compile(const char* const text, const int target, rule_t& rule, const scs_input_device_input_t* const inputs, char* const error, const size_t error_size);
+
+/**
+ * @brief Evaluates the rules in order.
+ *
+ * All rules see the inputs as they were before the first rule. A button is
+ * pressed when its expression is nonzero (on top of other sources), an axis
+ * is replaced by the value. Rules past the frame budget are skipped.
+ */
+void rule_run(const rule_set_t& rules, const telemetry_state_t& state, float* const axes, bool* const buttons);
+
+#endif // INPUT_SEMANTICAL_RULE_VM_H
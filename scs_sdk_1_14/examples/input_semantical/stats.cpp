@@ -0,0 +1,30 @@
+#include "stats.h"
+
+int stats_bucket(const scs_u64_t duration, const int bucket_count)
+{
+	int bucket = 0;
+	for (scs_u64_t limit = duration + 1; limit > 1 && bucket < bucket_count - 1; limit >>= 1)
+	{
+		bucket++;
+	}
+	return bucket;
+}
+
+void stats_frame(stats_t& stats, const scs_u64_t processing, const int torn_reads, const bool stale, const bool failsafe, const scs_u64_t page_faults)
+{
+	stats.frames.fetch_add(1, std::memory_order_relaxed);
+	if (torn_reads) {
+		stats.torn_reads.fetch_add(torn_reads, std::memory_order_relaxed);
+	}
+	if (stale) {
+		stats.stale_frames.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (failsafe) {
+		stats.failsafe_frames.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (page_faults) {
+		stats.page_faults.fetch_add(static_cast<scs_u32_t>(page_faults), std::memory_order_relaxed);
+		stats.faulting_frames.fetch_add(1, std::memory_order_relaxed);
+	}
+	stats.processing_histogram[stats_bucket(processing, statsHistogramBuckets)].fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,12 @@
+#ifndef INPUT_SEMANTICAL_STATS_H
+#define INPUT_SEMANTICAL_STATS_H
+
+#include "control_layout.h"
+
+// Index of the log2 histogram bucket of a duration in microseconds.
+int stats_bucket(const scs_u64_t duration, const int bucket_count);
+
+// Accounts one processed frame.
+void stats_frame(stats_t& stats, const scs_u64_t processing, const int torn_reads, const bool stale, const bool failsafe, const scs_u64_t page_faults);
+
+#endif // INPUT_SEMANTICAL_STATS_H
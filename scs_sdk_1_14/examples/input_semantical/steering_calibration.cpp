@@ -0,0 +1,282 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+#include "platform.h"
+#include "steering_calibration.h"
+
+// A command counts as settled once it stayed within the tolerance for this
+// long, the game smooths the steering so earlier samples would lag.
+const float calibrationSettleTolerance = 0.02f;
+const scs_u64_t calibrationSettleTime = 300000;
+
+// Cells with fewer samples are filled from their neighbours.
+const scs_u32_t calibrationMinimumSamples = 5;
+
+// Sweep: hold every column for this long, going back and forth.
+const scs_u64_t calibrationSweepStep = 1500000;
+
+static bool running = false;
+static bool sweeping = false;
+static scs_u64_t sweepStart = 0;
+
+static double sums[calibrationSpeedBins][calibrationSteeringBins];
+static scs_u32_t counts[calibrationSpeedBins][calibrationSteeringBins];
+
+static float anchor = 0.0f;
+static scs_u64_t anchorTime = 0;
+
+static float clamp(const float value, const float minimum, const float maximum)
+{
+	return value < minimum ? minimum : (value > maximum ? maximum : value);
+}
+
+static float column_value(const int column)
+{
+	return -1.0f + 2.0f * column / (calibrationSteeringBins - 1);
+}
+
+float steering_calibration_apply(const steering_table_t& table, const float speed, const float steering)
+{
+	const float row = clamp(fabsf(speed) / calibrationMaxSpeed, 0.0f, 1.0f) * (calibrationSpeedBins - 1);
+	const float column = (clamp(steering, -1.0f, 1.0f) + 1.0f) * 0.5f * (calibrationSteeringBins - 1);
+
+	const int r = static_cast<int>(row) < calibrationSpeedBins - 1 ? static_cast<int>(row) : calibrationSpeedBins - 2;
+	const int c = static_cast<int>(column) < calibrationSteeringBins - 1 ? static_cast<int>(column) : calibrationSteeringBins - 2;
+	const float fr = row - r;
+	const float fc = column - c;
+
+	const float top = table.inputs[r][c] + (table.inputs[r][c + 1] - table.inputs[r][c]) * fc;
+	const float bottom = table.inputs[r + 1][c] + (table.inputs[r + 1][c + 1] - table.inputs[r + 1][c]) * fc;
+	return top + (bottom - top) * fr;
+}
+
+static void start(calibration_t& published, const bool sweep, const scs_u64_t time)
+{
+	memset(sums, 0, sizeof(sums));
+	memset(counts, 0, sizeof(counts));
+	running = true;
+	sweeping = sweep;
+	sweepStart = time;
+	anchorTime = 0;
+	published.samples.store(0, std::memory_order_relaxed);
+	published.filled_cells.store(0, std::memory_order_relaxed);
+	published.state.store(sweep ? calibration_state_sweeping : calibration_state_observing, std::memory_order_relaxed);
+	log_line("Steering calibration started (%s).", sweep ? "sweep" : "observe");
+}
+
+// Effective steering for every input column of one speed row, false when
+// the row has too few samples.
+static bool fit_row(const int row, float* const effective)
+{
+	int valid[calibrationSteeringBins];
+	int validCount = 0;
+	for (int c = 0; c < calibrationSteeringBins; c++)
+	{
+		if (counts[row][c] >= calibrationMinimumSamples) {
+			effective[c] = static_cast<float>(sums[row][c] / counts[row][c]);
+			valid[validCount++] = c;
+		}
+	}
+	if (validCount < 2) {
+		return false;
+	}
+
+	// Interpolate the gaps, extrapolate the ends with the nearest slope.
+	for (int c = 0; c < calibrationSteeringBins; c++)
+	{
+		int k = 0;
+		while (k < validCount - 2 && valid[k + 1] < c) {
+			k++;
+		}
+		const int a = valid[k];
+		const int b = valid[k + 1];
+		if (counts[row][c] < calibrationMinimumSamples) {
+			effective[c] = effective[a] + (effective[b] - effective[a]) * (c - a) / static_cast<float>(b - a);
+		}
+	}
+
+	// Keep it monotonic in the overall direction so that it can be inverted.
+	const bool rising = effective[calibrationSteeringBins - 1] >= effective[0];
+	for (int c = 1; c < calibrationSteeringBins; c++)
+	{
+		effective[c] = rising ? fmaxf(effective[c], effective[c - 1]) : fminf(effective[c], effective[c - 1]);
+	}
+	return true;
+}
+
+// Axis input reaching the desired effective steering on one fitted row.
+static float invert_row(const float* const effective, const float desired)
+{
+	for (int c = 0; c < calibrationSteeringBins - 1; c++)
+	{
+		const float a = effective[c];
+		const float b = effective[c + 1];
+		if ((desired - a) * (desired - b) <= 0.0f && a != b) {
+			return column_value(c) + (column_value(c + 1) - column_value(c)) * (desired - a) / (b - a);
+		}
+	}
+
+	// Out of reach, use the input getting closest.
+	return fabsf(desired - effective[0]) < fabsf(desired - effective[calibrationSteeringBins - 1]) ? column_value(0) : column_value(calibrationSteeringBins - 1);
+}
+
+static bool fit(steering_table_t& table)
+{
+	float effective[calibrationSpeedBins][calibrationSteeringBins];
+	bool fitted[calibrationSpeedBins];
+	bool any = false;
+	for (int r = 0; r < calibrationSpeedBins; r++)
+	{
+		fitted[r] = fit_row(r, effective[r]);
+		any = any || fitted[r];
+	}
+	if (!any) {
+		return false;
+	}
+
+	for (int r = 0; r < calibrationSpeedBins; r++)
+	{
+		// Rows without data borrow the nearest fitted row.
+		int source = r;
+		for (int distance = 1; !fitted[source]; distance++)
+		{
+			if (r - distance >= 0 && fitted[r - distance]) {
+				source = r - distance;
+			}
+			else if (r + distance < calibrationSpeedBins && fitted[r + distance]) {
+				source = r + distance;
+			}
+		}
+		for (int c = 0; c < calibrationSteeringBins; c++)
+		{
+			table.inputs[r][c] = invert_row(effective[source], column_value(c));
+		}
+	}
+	table.rows_loaded = (1u << calibrationSpeedBins) - 1;
+	table.valid = true;
+	return true;
+}
+
+// Header, one "speedN =" per row and " -0.1234" per cell, formatted in
+// place so that finishing from the input callback does not allocate.
+static char fileText[256 + calibrationSpeedBins * (16 + calibrationSteeringBins * 8)];
+
+static bool write(const steering_table_t& table, const char* const path)
+{
+	int length = snprintf(fileText, sizeof(fileText),
+		"; Written by the steering calibration. Rows are speeds from 0 to %g m/s, columns\n"
+		"; the desired effective steering from -1 to 1, values the steering axis input.\n"
+		"[steering_calibration]\n", calibrationMaxSpeed);
+	for (int r = 0; r < calibrationSpeedBins; r++)
+	{
+		length += snprintf(fileText + length, sizeof(fileText) - length, "speed%d =", r);
+		for (int c = 0; c < calibrationSteeringBins; c++)
+		{
+			length += snprintf(fileText + length, sizeof(fileText) - length, " %.4f", clamp(table.inputs[r][c], -1.0f, 1.0f));
+		}
+		length += snprintf(fileText + length, sizeof(fileText) - length, "\n");
+	}
+	return file_write(path, fileText, length);
+}
+
+static void finish(calibration_t& published, steering_table_t& table, const char* const path)
+{
+	running = false;
+	sweeping = false;
+
+	steering_table_t fitted;
+	memset(&fitted, 0, sizeof(fitted));
+	if (!fit(fitted)) {
+		published.state.store(calibration_state_failed, std::memory_order_relaxed);
+		log_error("Steering calibration has too few samples.");
+		return;
+	}
+	if (!write(fitted, path)) {
+		log_error("Failed to write steering calibration %s.", path);
+	}
+	table = fitted;
+	published.state.store(calibration_state_done, std::memory_order_relaxed);
+	log_line("Steering calibration stored in %s.", path);
+}
+
+static void collect(calibration_t& published, const telemetry_state_t& state, const scs_u64_t time, const float steering)
+{
+	if (anchorTime == 0 || fabsf(steering - anchor) > calibrationSettleTolerance) {
+		anchor = steering;
+		anchorTime = time;
+		return;
+	}
+	if (time - anchorTime < calibrationSettleTime || state.paused) {
+		return;
+	}
+
+	const float row = clamp(fabsf(state.speed) / calibrationMaxSpeed, 0.0f, 1.0f) * (calibrationSpeedBins - 1);
+	const float column = (clamp(steering, -1.0f, 1.0f) + 1.0f) * 0.5f * (calibrationSteeringBins - 1);
+	const int r = static_cast<int>(row + 0.5f);
+	const int c = static_cast<int>(column + 0.5f);
+
+	if (counts[r][c]++ == calibrationMinimumSamples - 1) {
+		published.filled_cells.fetch_add(1, std::memory_order_relaxed);
+	}
+	sums[r][c] += state.effective_steering;
+	published.samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void steering_calibration_update(calibration_t& published, const telemetry_state_t& state, const scs_u64_t time, float& steering, steering_table_t& table, const char* const path)
+{
+	const scs_u32_t command = published.command.exchange(calibration_command_none, std::memory_order_acq_rel);
+	switch (command)
+	{
+	case calibration_command_observe:
+	case calibration_command_sweep:
+		if (!state.active) {
+			published.state.store(calibration_state_failed, std::memory_order_relaxed);
+			log_error("Steering calibration needs the telemetry.");
+			break;
+		}
+		start(published, command == calibration_command_sweep, time);
+		break;
+	case calibration_command_finish:
+		if (running) {
+			finish(published, table, path);
+		}
+		break;
+	case calibration_command_cancel:
+		if (running) {
+			running = false;
+			sweeping = false;
+			published.state.store(calibration_state_idle, std::memory_order_relaxed);
+			log_line("Steering calibration cancelled.");
+		}
+		break;
+	}
+
+	if (!running) {
+		return;
+	}
+
+	if (sweeping) {
+		// Step through the columns and back again.
+		const int steps = 2 * (calibrationSteeringBins - 1);
+		const int step = static_cast<int>(((time - sweepStart) / calibrationSweepStep) % steps);
+		steering = column_value(step < calibrationSteeringBins ? step : steps - step);
+	}
+
+	// The effective steering follows the input sent in the previous frames,
+	// collect() only uses inputs that did not change for a while.
+	collect(published, state, time, steering);
+}
+
+bool steering_calibration_running(void)
+{
+	return running;
+}
+
+void steering_calibration_reset(void)
+{
+	running = false;
+	sweeping = false;
+	anchorTime = 0;
+}
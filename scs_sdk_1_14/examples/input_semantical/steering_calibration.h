@@ -0,0 +1,49 @@
+/**
+ * @brief Steering calibration.
+ *
+ * The game applies its own nonlinear and speed dependent response between
+ * the steering axis and truck.effective.steering. In calibration mode the
+ * plugin collects (input, speed, effective) samples from the telemetry,
+ * fits the inverse response and writes it to the calibration file. With a
+ * table loaded, the steering value the plugin receives is treated as the
+ * desired effective steering and converted to the axis input through a
+ * bilinear lookup.
+ */
+#ifndef INPUT_SEMANTICAL_STEERING_CALIBRATION_H
+#define INPUT_SEMANTICAL_STEERING_CALIBRATION_H
+
+#include "control_layout.h"
+#include "telemetry.h"
+
+const int calibrationSpeedBins = 8;		// 0 to calibrationMaxSpeed
+const int calibrationSteeringBins = 17;		// -1 to 1
+const float calibrationMaxSpeed = 30.0f;	// m/s
+const char* const defaultCalibrationPath = "steering_calibration.ini";
+
+struct steering_table_t
+{
+	bool valid;
+	scs_u32_t rows_loaded;		// bit per speed bin, used while loading
+	// Axis input producing the effective steering of the column at the
+	// speed of the row.
+	float inputs[calibrationSpeedBins][calibrationSteeringBins];
+};
+
+// Converts a desired effective steering to the axis input.
+float steering_calibration_apply(const steering_table_t& table, const float speed, const float steering);
+
+/**
+ * @brief Runs the calibration commands of the producer for one frame.
+ *
+ * While sweeping, replaces the steering value with the sweep. When the
+ * producer finishes the calibration, fits the table, writes it to the path
+ * and replaces the given table with it.
+ */
+void steering_calibration_update(calibration_t& published, const telemetry_state_t& state, const scs_u64_t time, float& steering, steering_table_t& table, const char* const path);
+
+// True while samples are being collected, the table must not be applied then.
+bool steering_calibration_running(void);
+
+void steering_calibration_reset(void);
+
+#endif // INPUT_SEMANTICAL_STEERING_CALIBRATION_H
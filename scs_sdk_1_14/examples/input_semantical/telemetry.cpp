@@ -0,0 +1,255 @@
+/**
+ * @brief Telemetry side of the plugin.
+ *
+ * Keeps the latest truck state for the input device and writes it to a
+ * chunked recording (see recording_format.h) while the player is driving.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "activity.h"
+#include "config.h"
+#include "log.h"
+#include "telemetry.h"
+#include "telemetry_recorder.h"
+
+#include "common/scssdk_telemetry_common_channels.h"
+#include "common/scssdk_telemetry_truck_common_channels.h"
+
+// [recording] settings, off until the input side configures them.
+static bool recordingEnabled = false;
+static char recordingPath[configNameSize] = "";
+
+telemetry_state_t telemetry;
+
+static telemetry_snapshot_t* shared = NULL;
+static scs_u32_t sharedFrames = 0;
+
+void telemetry_share(telemetry_snapshot_t* const snapshot)
+{
+	shared = snapshot;
+}
+
+static void publish(void)
+{
+	const scs_u32_t sequence = shared->sequence.load(std::memory_order_relaxed);
+	shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	telemetry_values_t& values = shared->values;
+	values.simulation_time = telemetry.simulation_time;
+	values.frames = ++sharedFrames;
+	values.game_time = telemetry.game_time;
+	values.paused = telemetry.paused ? 1 : 0;
+	values.gear = telemetry.engine_gear;
+	values.speed = telemetry.speed;
+	values.input_steering = telemetry.input_steering;
+	values.input_throttle = telemetry.input_throttle;
+	values.input_brake = telemetry.input_brake;
+	values.input_clutch = telemetry.input_clutch;
+	values.effective_steering = telemetry.effective_steering;
+	values.effective_throttle = telemetry.effective_throttle;
+	values.effective_brake = telemetry.effective_brake;
+	values.effective_clutch = telemetry.effective_clutch;
+	values.rpm = telemetry.engine_rpm;
+	values.angular_velocity[0] = telemetry.angular_velocity.x;
+	values.angular_velocity[1] = telemetry.angular_velocity.y;
+	values.angular_velocity[2] = telemetry.angular_velocity.z;
+	values.heading = telemetry.world_placement.orientation.heading;
+	values.pitch = telemetry.world_placement.orientation.pitch;
+	values.roll = telemetry.world_placement.orientation.roll;
+	values.position[0] = telemetry.world_placement.position.x;
+	values.position[1] = telemetry.world_placement.position.y;
+	values.position[2] = telemetry.world_placement.position.z;
+
+	shared->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+#define UNUSED(x)
+
+SCSAPI_VOID telemetry_frame_start(const scs_event_t UNUSED(event), const void *const event_info, const scs_context_t UNUSED(context))
+{
+	const struct scs_telemetry_frame_start_t *const info = static_cast<const scs_telemetry_frame_start_t *>(event_info);
+
+	telemetry.render_time = info->render_time;
+	telemetry.simulation_time = info->simulation_time;
+	telemetry.paused_simulation_time = info->paused_simulation_time;
+}
+
+SCSAPI_VOID telemetry_frame_end(const scs_event_t UNUSED(event), const void *const UNUSED(event_info), const scs_context_t UNUSED(context))
+{
+	if (shared) {
+		publish();
+	}
+	if (telemetry.paused) {
+		return;
+	}
+
+	recording_sample_t sample;
+	sample.time = telemetry.simulation_time;
+	sample.values[recording_channel_speed] = telemetry.speed;
+	sample.values[recording_channel_steering] = telemetry.input_steering;
+	sample.values[recording_channel_throttle] = telemetry.input_throttle;
+	sample.values[recording_channel_brake] = telemetry.input_brake;
+	sample.values[recording_channel_clutch] = telemetry.input_clutch;
+	sample.values[recording_channel_effective_steering] = telemetry.effective_steering;
+	sample.values[recording_channel_effective_throttle] = telemetry.effective_throttle;
+	sample.values[recording_channel_effective_brake] = telemetry.effective_brake;
+	sample.values[recording_channel_effective_clutch] = telemetry.effective_clutch;
+	sample.values[recording_channel_rpm] = telemetry.engine_rpm;
+	sample.values[recording_channel_gear] = static_cast<float>(telemetry.engine_gear);
+	sample.values[recording_channel_x] = static_cast<float>(telemetry.world_placement.position.x);
+	sample.values[recording_channel_y] = static_cast<float>(telemetry.world_placement.position.y);
+	sample.values[recording_channel_z] = static_cast<float>(telemetry.world_placement.position.z);
+	sample.values[recording_channel_heading] = telemetry.world_placement.orientation.heading;
+	sample.values[recording_channel_game_time] = static_cast<float>(telemetry.game_time);
+	recorder_append(sample);
+}
+
+SCSAPI_VOID telemetry_pause(const scs_event_t event, const void *const UNUSED(event_info), const scs_context_t UNUSED(context))
+{
+	telemetry.paused = (event == SCS_TELEMETRY_EVENT_paused);
+	activity_set_game_running(!telemetry.paused);
+
+	// Get whatever was driven so far to disk while the game sits in a menu.
+	if (telemetry.paused) {
+		recorder_flush();
+	}
+}
+
+// Channel storage callbacks.
+
+SCSAPI_VOID telemetry_store_float(const scs_string_t UNUSED(name), const scs_u32_t UNUSED(index), const scs_value_t *const value, const scs_context_t context)
+{
+	*static_cast<scs_float_t *>(context) = value ? value->value_float.value : 0.0f;
+}
+
+SCSAPI_VOID telemetry_store_s32(const scs_string_t UNUSED(name), const scs_u32_t UNUSED(index), const scs_value_t *const value, const scs_context_t context)
+{
+	*static_cast<scs_s32_t *>(context) = value ? value->value_s32.value : 0;
+}
+
+SCSAPI_VOID telemetry_store_u32(const scs_string_t UNUSED(name), const scs_u32_t UNUSED(index), const scs_value_t *const value, const scs_context_t context)
+{
+	*static_cast<scs_u32_t *>(context) = value ? value->value_u32.value : 0;
+}
+
+SCSAPI_VOID telemetry_store_fvector(const scs_string_t UNUSED(name), const scs_u32_t UNUSED(index), const scs_value_t *const value, const scs_context_t context)
+{
+	scs_value_fvector_t *const vector = static_cast<scs_value_fvector_t *>(context);
+	if (value) {
+		*vector = value->value_fvector;
+	}
+	else {
+		memset(vector, 0, sizeof(*vector));
+	}
+}
+
+SCSAPI_VOID telemetry_store_dplacement(const scs_string_t UNUSED(name), const scs_u32_t UNUSED(index), const scs_value_t *const value, const scs_context_t context)
+{
+	scs_value_dplacement_t *const placement = static_cast<scs_value_dplacement_t *>(context);
+	if (value) {
+		*placement = value->value_dplacement;
+	}
+	else {
+		memset(placement, 0, sizeof(*placement));
+	}
+}
+
+// One file per initialization so "sdk reinit" does not truncate the
+// previous recording.
+static void start_recording(void)
+{
+	const time_t now = time(NULL);
+	const size_t length = strlen(recordingPath);
+	const bool separator = length > 0 && recordingPath[length - 1] != '/' && recordingPath[length - 1] != '\\';
+	char path[configNameSize + 32];
+	snprintf(path, sizeof(path), "%s%stelemetry_%lld.rec", recordingPath, separator ? "/" : "", static_cast<long long>(now));
+	recorder_start(path, now);
+}
+
+void telemetry_configure_recording(const bool enabled, const char* const path)
+{
+	recordingEnabled = enabled;
+	strncpy(recordingPath, path, sizeof(recordingPath) - 1);
+	recordingPath[sizeof(recordingPath) - 1] = '\0';
+	if (!enabled) {
+		recorder_stop();
+	}
+	else if (telemetry.active) {
+		start_recording();
+	}
+}
+
+/**
+ * @brief Telemetry API initialization function.
+ *
+ * See scssdk_telemetry.h
+ */
+SCSAPI_RESULT scs_telemetry_init(const scs_u32_t version, const scs_telemetry_init_params_t *const params)
+{
+	init_log();
+
+	// We currently support only one version.
+	if (version != SCS_TELEMETRY_VERSION_1_01) {
+		return SCS_RESULT_unsupported;
+	}
+
+	const scs_telemetry_init_params_v101_t *const version_params = static_cast<const scs_telemetry_init_params_v101_t *>(params);
+
+	const bool events_registered =
+		(version_params->register_for_event(SCS_TELEMETRY_EVENT_frame_start, telemetry_frame_start, NULL) == SCS_RESULT_ok) &&
+		(version_params->register_for_event(SCS_TELEMETRY_EVENT_frame_end, telemetry_frame_end, NULL) == SCS_RESULT_ok) &&
+		(version_params->register_for_event(SCS_TELEMETRY_EVENT_paused, telemetry_pause, NULL) == SCS_RESULT_ok) &&
+		(version_params->register_for_event(SCS_TELEMETRY_EVENT_started, telemetry_pause, NULL) == SCS_RESULT_ok)
+	;
+	if (!events_registered) {
+		version_params->common.log(SCS_LOG_TYPE_error, "Unable to register telemetry event callbacks");
+		return SCS_RESULT_generic_error;
+	}
+
+	// Channels which the game does not provide simply keep their zero value.
+
+	memset(&telemetry, 0, sizeof(telemetry));
+	telemetry.active = true;
+	telemetry.paused = true;
+	// The telemetry starts paused, the started event resumes it.
+	activity_set_game_running(false);
+
+	version_params->register_for_channel(SCS_TELEMETRY_CHANNEL_game_time, SCS_U32_NIL, SCS_VALUE_TYPE_u32, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_u32, &telemetry.game_time);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_speed, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.speed);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_input_steering, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.input_steering);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_input_throttle, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.input_throttle);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_input_brake, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.input_brake);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_input_clutch, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.input_clutch);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_effective_steering, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.effective_steering);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_effective_throttle, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.effective_throttle);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_effective_brake, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.effective_brake);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_effective_clutch, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.effective_clutch);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_engine_rpm, SCS_U32_NIL, SCS_VALUE_TYPE_float, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_float, &telemetry.engine_rpm);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_engine_gear, SCS_U32_NIL, SCS_VALUE_TYPE_s32, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_s32, &telemetry.engine_gear);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_world_placement, SCS_U32_NIL, SCS_VALUE_TYPE_dplacement, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_dplacement, &telemetry.world_placement);
+	version_params->register_for_channel(SCS_TELEMETRY_TRUCK_CHANNEL_local_angular_velocity, SCS_U32_NIL, SCS_VALUE_TYPE_fvector, SCS_TELEMETRY_CHANNEL_FLAG_none, telemetry_store_fvector, &telemetry.angular_velocity);
+
+	if (recordingEnabled) {
+		start_recording();
+	}
+
+	log_line("Telemetry initialized.");
+
+	return SCS_RESULT_ok;
+}
+
+/**
+ * @brief Telemetry API deinitialization function.
+ *
+ * See scssdk_telemetry.h
+ */
+SCSAPI_VOID scs_telemetry_shutdown(void)
+{
+	recorder_stop();
+	telemetry.active = false;
+	activity_set_game_running(true);
+}
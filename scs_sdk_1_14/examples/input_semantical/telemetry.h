@@ -0,0 +1,51 @@
+#ifndef INPUT_SEMANTICAL_TELEMETRY_H
+#define INPUT_SEMANTICAL_TELEMETRY_H
+
+#include "control_layout.h"
+
+#include "scssdk_telemetry.h"
+
+/**
+ * @brief Latest values of the telemetry channels the plugin listens to.
+ *
+ * Only touched from the game main thread, same as the input callbacks.
+ */
+struct telemetry_state_t
+{
+	bool active;		// between scs_telemetry_init and scs_telemetry_shutdown
+	scs_timestamp_t render_time;
+	scs_timestamp_t simulation_time;
+	scs_timestamp_t paused_simulation_time;
+	bool paused;
+
+	scs_u32_t game_time;
+	scs_float_t speed;
+	scs_float_t input_steering;
+	scs_float_t input_throttle;
+	scs_float_t input_brake;
+	scs_float_t input_clutch;
+	scs_float_t effective_steering;
+	scs_float_t effective_throttle;
+	scs_float_t effective_brake;
+	scs_float_t effective_clutch;
+	scs_float_t engine_rpm;
+	scs_s32_t engine_gear;
+	scs_value_dplacement_t world_placement;
+	scs_value_fvector_t angular_velocity;	// rotations per second, vehicle space
+};
+
+extern telemetry_state_t telemetry;
+
+// Starts (or with NULL stops) publishing every telemetry frame into the block.
+void telemetry_share(telemetry_snapshot_t* const snapshot);
+
+/**
+ * @brief Applies the [recording] settings of the configuration.
+ *
+ * Recording is off until the input side calls this at its init. Starts the
+ * recording when telemetry is already running and stops a running one when
+ * recording got disabled. Allocates, so not from a callback.
+ */
+void telemetry_configure_recording(const bool enabled, const char* const path);
+
+#endif // INPUT_SEMANTICAL_TELEMETRY_H
@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "log.h"
+#include "platform.h"
+#include "telemetry_recorder.h"
+
+// Number of chunk buffers between the game thread and the writer. When the
+// writer falls this far behind, whole chunks are dropped instead of blocking
+// the game.
+const int recorderChunkCount = 4;
+
+struct recorder_chunk_t
+{
+	int sample_count;
+	recording_sample_t samples[recordingChunkSamples];
+};
+
+// The ring is allocated per recording, so it can come from large pages.
+static recorder_chunk_t* chunks = NULL;
+static const size_t chunksSize = recorderChunkCount * sizeof(recorder_chunk_t);
+static bool chunksLarge = false;
+static bool chunksPrefaulted = false;
+static bool chunksLocked = false;
+
+// [memory] settings, the defaults until the input side configures them.
+static bool prefaultChunks = true;
+static bool lockChunks = false;
+static bool largeChunks = false;
+
+static int fillChunk = 0;
+static int writeChunk = 0;
+static int queuedChunks = 0;
+static unsigned droppedChunks = 0;
+static bool stopWriter = false;
+
+static FILE* recordingFile = NULL;
+static char recordingPath[256];
+static scs_u64_t fileOffset = 0;		// end of the last complete chunk
+
+// Set by the writer after a failed write, which already closed the file.
+static std::atomic<bool> writeFailed(false);
+
+static std::thread writerThread;
+static std::mutex recorderMutex;
+static std::condition_variable recorderWake;
+
+static bool write_chunk(const recorder_chunk_t& chunk)
+{
+	const int count = chunk.sample_count;
+	const scs_u64_t samplesOffset = fileOffset + sizeof(recording_chunk_header_t);
+
+	recording_chunk_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = recordingChunkMagic;
+	header.sample_count = count;
+	header.first_time = chunk.samples[0].time;
+	header.last_time = chunk.samples[count - 1].time;
+	header.footer_offset = samplesOffset + count * sizeof(recording_sample_t);
+	header.next_offset = header.footer_offset + sizeof(recording_chunk_footer_t);
+
+	recording_chunk_footer_t footer;
+	memset(&footer, 0, sizeof(footer));
+	footer.magic = recordingFooterMagic;
+	for (int c = 0; c < recording_channel_count; c++)
+	{
+		footer.minimum[c] = chunk.samples[0].values[c];
+		footer.maximum[c] = chunk.samples[0].values[c];
+	}
+	for (int i = 0; i < count; i++)
+	{
+		const recording_sample_t& sample = chunk.samples[i];
+		for (int c = 0; c < recording_channel_count; c++)
+		{
+			if (sample.values[c] < footer.minimum[c]) {
+				footer.minimum[c] = sample.values[c];
+			}
+			if (sample.values[c] > footer.maximum[c]) {
+				footer.maximum[c] = sample.values[c];
+			}
+		}
+		if (i % recordingIndexStride == 0) {
+			recording_index_entry_t& entry = footer.index[footer.index_count++];
+			entry.time = sample.time;
+			entry.offset = samplesOffset + i * sizeof(recording_sample_t);
+		}
+	}
+
+	const bool written = fwrite(&header, sizeof(header), 1, recordingFile) == 1 &&
+		fwrite(chunk.samples, sizeof(recording_sample_t), count, recordingFile) == static_cast<size_t>(count) &&
+		fwrite(&footer, sizeof(footer), 1, recordingFile) == 1 && fflush(recordingFile) == 0;
+	if (written) {
+		fileOffset = header.next_offset;
+	}
+	return written;
+}
+
+// Ends the recording at the last complete chunk, e.g. when the disk is full,
+// so the offsets in the file stay valid. Called by the writer.
+static void fail_recording(void)
+{
+	log_error("Failed to write the recording %s, it ends after %llu bytes.", recordingPath, static_cast<unsigned long long>(fileOffset));
+	fclose(recordingFile);
+	file_truncate(recordingPath, fileOffset);
+	writeFailed.store(true, std::memory_order_release);
+}
+
+static bool allocate_chunks(void)
+{
+	bool large = false;
+	recorder_chunk_t* const allocated = static_cast<recorder_chunk_t*>(memory_allocate(chunksSize, largeChunks, large));
+	if (!allocated) {
+		return false;
+	}
+	if (largeChunks && !large) {
+		log_line("No large pages available for the recording, using normal pages.");
+	}
+	chunks = allocated;
+	chunksLarge = large;
+	chunksPrefaulted = false;
+	chunksLocked = false;
+	return true;
+}
+
+static void free_chunks(void)
+{
+	if (chunksLocked) {
+		memory_unlock(chunks, chunksSize);
+	}
+	memory_free(chunks, chunksSize, chunksLarge);
+	chunks = NULL;
+	chunksLocked = false;
+}
+
+static void prepare_chunks(recorder_memory_t& state)
+{
+	if (prefaultChunks && !chunksPrefaulted) {
+		state.pages += memory_prefault(chunks, chunksSize);
+		chunksPrefaulted = true;
+	}
+	if (lockChunks && !chunksLocked) {
+		chunksLocked = memory_lock(chunks, chunksSize);
+		state.lock_failed = !chunksLocked;
+	}
+	else if (!lockChunks && chunksLocked) {
+		memory_unlock(chunks, chunksSize);
+		chunksLocked = false;
+	}
+	state.large = chunksLarge;
+}
+
+static void writer_main(void)
+{
+	std::unique_lock<std::mutex> lock(recorderMutex);
+	for (;;)
+	{
+		recorderWake.wait(lock, [] { return queuedChunks > 0 || stopWriter; });
+		if (queuedChunks == 0) {
+			return;
+		}
+
+		recorder_chunk_t& chunk = chunks[writeChunk];
+		lock.unlock();
+		if (!writeFailed.load(std::memory_order_relaxed) && !write_chunk(chunk)) {
+			fail_recording();
+		}
+		lock.lock();
+
+		chunk.sample_count = 0;
+		writeChunk = (writeChunk + 1) % recorderChunkCount;
+		queuedChunks--;
+	}
+}
+
+bool recorder_start(const char* const path, const time_t start_time)
+{
+	if (recordingFile) {
+		return true;
+	}
+
+	recordingFile = fopen(path, "wb");
+	if (!recordingFile) {
+		log_line("Failed to open recording file %s.", path);
+		return false;
+	}
+	strncpy(recordingPath, path, sizeof(recordingPath) - 1);
+	recordingPath[sizeof(recordingPath) - 1] = '\0';
+	writeFailed.store(false, std::memory_order_relaxed);
+
+	recording_file_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, recordingMagic, sizeof(header.magic));
+	header.version = recordingVersion;
+	header.channel_count = recording_channel_count;
+	header.chunk_samples = recordingChunkSamples;
+	header.index_stride = recordingIndexStride;
+	header.start_unix_time = start_time;
+	for (int c = 0; c < recording_channel_count; c++)
+	{
+		strncpy(header.channel_names[c], recordingChannelNames[c], recordingChannelNameSize - 1);
+	}
+	if (fwrite(&header, sizeof(header), 1, recordingFile) != 1) {
+		log_line("Failed to write recording file %s.", path);
+		fclose(recordingFile);
+		recordingFile = NULL;
+		return false;
+	}
+	fileOffset = sizeof(header);
+
+	if (!allocate_chunks()) {
+		log_error("Failed to allocate the recording buffers.");
+		fclose(recordingFile);
+		recordingFile = NULL;
+		return false;
+	}
+	recorder_memory_t state;
+	memset(&state, 0, sizeof(state));
+	prepare_chunks(state);
+
+	fillChunk = 0;
+	writeChunk = 0;
+	queuedChunks = 0;
+	droppedChunks = 0;
+	stopWriter = false;
+	writerThread = std::thread(writer_main);
+
+	log_line("Recording telemetry to %s.", path);
+	return true;
+}
+
+void recorder_append(const recording_sample_t& sample)
+{
+	if (!recordingFile || writeFailed.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	recorder_chunk_t& chunk = chunks[fillChunk];
+	chunk.samples[chunk.sample_count++] = sample;
+	if (chunk.sample_count == recordingChunkSamples) {
+		recorder_flush();
+	}
+}
+
+void recorder_flush(void)
+{
+	if (!recordingFile || chunks[fillChunk].sample_count == 0) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(recorderMutex);
+		if (queuedChunks == recorderChunkCount - 1) {
+			// The writer still owns every other buffer, drop this one.
+			chunks[fillChunk].sample_count = 0;
+			droppedChunks++;
+			return;
+		}
+		queuedChunks++;
+		fillChunk = (fillChunk + 1) % recorderChunkCount;
+	}
+	recorderWake.notify_one();
+}
+
+void recorder_stop(void)
+{
+	if (!recordingFile) {
+		return;
+	}
+
+	recorder_flush();
+	{
+		std::lock_guard<std::mutex> lock(recorderMutex);
+		stopWriter = true;
+	}
+	recorderWake.notify_one();
+	writerThread.join();
+
+	if (!writeFailed.load(std::memory_order_acquire)) {
+		fclose(recordingFile);
+	}
+	recordingFile = NULL;
+	free_chunks();
+
+	if (droppedChunks) {
+		log_line("Recording dropped %u chunks.", droppedChunks);
+	}
+}
+
+void recorder_configure_memory(const bool prefault, const bool lock, const bool large_pages, recorder_memory_t& state)
+{
+	memset(&state, 0, sizeof(state));
+	prefaultChunks = prefault;
+	lockChunks = lock;
+	largeChunks = large_pages;
+	if (!recordingFile) {
+		return;
+	}
+
+	// The writer is idle and owns no chunk while nothing is queued.
+	std::lock_guard<std::mutex> guard(recorderMutex);
+	if (large_pages != chunksLarge && queuedChunks == 0 && chunks[fillChunk].sample_count == 0) {
+		recorder_chunk_t* const previous = chunks;
+		const bool previousLarge = chunksLarge;
+		const bool previousLocked = chunksLocked;
+		if (allocate_chunks()) {
+			if (previousLocked) {
+				memory_unlock(previous, chunksSize);
+			}
+			memory_free(previous, chunksSize, previousLarge);
+			fillChunk = 0;
+			writeChunk = 0;
+		}
+	}
+	prepare_chunks(state);
+}
@@ -0,0 +1,34 @@
+#ifndef INPUT_SEMANTICAL_TELEMETRY_RECORDER_H
+#define INPUT_SEMANTICAL_TELEMETRY_RECORDER_H
+
+#include "recording_format.h"
+
+/**
+ * @brief Chunked telemetry recorder.
+ *
+ * The game thread only copies samples into a fixed ring of chunk buffers.
+ * Full chunks are indexed and written to disk by a background thread so
+ * the file I/O never happens inside a telemetry callback.
+ */
+bool recorder_start(const char* const path, const time_t start_time);
+void recorder_append(const recording_sample_t& sample);
+void recorder_flush(void);
+void recorder_stop(void);
+
+struct recorder_memory_t
+{
+	size_t pages;		// pre-faulted by this call
+	bool lock_failed;
+	bool large;		// the ring of the running recording has large pages
+};
+
+/**
+ * @brief Memory settings of the chunk ring, see [memory] in the configuration.
+ *
+ * Applied to the ring of the running recording and kept for later ones. A
+ * running recording only moves to large pages while it is still empty,
+ * as it is at load. Allocates, so it must not be called from a callback.
+ */
+void recorder_configure_memory(const bool prefault, const bool lock, const bool large_pages, recorder_memory_t& state);
+
+#endif // INPUT_SEMANTICAL_TELEMETRY_RECORDER_H
@@ -0,0 +1,1045 @@
+/**
+ * @brief Minimal stand-in for the game which loads the plugin and drives it.
+ *
+ * Emulates the input API the way the game uses it: the plugin registers its
+ * devices from scs_input_init and every frame the event callback of each
+ * device is called until it returns SCS_RESULT_not_found.
+ *
+ * With --replay the control block is fed from an input_capture file on a
+ * virtual clock advancing by 1/fps per frame, so the emitted events depend
+ * only on the capture and the plugin. The plugin takes its frame time from
+ * the same clock through input_semantical_set_clock, so its timeouts do not
+ * depend on --speed either. The events are written to --output as
+ *
+ *   per frame and device: u32 frame, u32 device, u32 count, count * scs_input_event_t
+ *
+ * and can be compared byte for byte with a previous run with --compare.
+ *
+ * Frames follow each other without delay with --speed 0, so a producer using
+ * the lockstep handshake (see frame_sync_t) gets a frame-accurate closed loop
+ * running as fast as it can answer.
+ *
+ * With --telemetry the telemetry API of the plugin is driven as well, with
+ * a frame start, the channels and a frame end around every input frame.
+ * --check-allocations replaces malloc for the whole process and fails the
+ * run when any callback into the plugin allocates after its initialization.
+ *
+ * fake_host --layout-bench runs the producer and the plugin side of the
+ * frame handshake on two threads against the control block and against a
+ * replica of the packed version 1 layout, where both sides wrote to the
+ * same cache lines, without loading any plugin.
+ */
+
+#ifdef _WIN32
+#  define WINVER 0x0500
+#  define _WIN32_WINNT 0x0500
+#  include <windows.h>
+#else
+#  include <dlfcn.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../control_layout.h"
+#include "../frame_sync.h"
+#include "../instance_registry.h"
+#include "../platform.h"
+#include "input_capture_format.h"
+
+#include "scssdk_input.h"
+#include "scssdk_telemetry.h"
+#include "common/scssdk_telemetry_truck_common_channels.h"
+#include "eurotrucks2/scssdk_eut2.h"
+#include "eurotrucks2/scssdk_input_eut2.h"
+#include "amtrucks/scssdk_ats.h"
+#include "amtrucks/scssdk_input_ats.h"
+#include "amtrucks/scssdk_telemetry_ats.h"
+#include "eurotrucks2/scssdk_telemetry_eut2.h"
+
+typedef SCSAPI_RESULT_FPTR(scs_input_init_t)(const scs_u32_t version, const scs_input_init_params_t *const params);
+typedef SCSAPI_VOID_FPTR(scs_input_shutdown_t)(void);
+typedef SCSAPI_RESULT_FPTR(scs_telemetry_init_t)(const scs_u32_t version, const scs_telemetry_init_params_t *const params);
+typedef SCSAPI_VOID_FPTR(scs_telemetry_shutdown_t)(void);
+typedef SCSAPI_VOID_FPTR(set_clock_t)(const frame_clock_t clock);
+
+// Allocation check. With glibc the malloc family defined here replaces the
+// one of the C library for the plugin too, allocations made while
+// inCallback is set on the calling thread are counted. The writer threads
+// of the plugin may allocate, they never set it.
+#ifdef __GLIBC__
+#  define ALLOCATION_CHECK
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+
+static bool checkAllocations = false;
+static thread_local bool inCallback = false;
+static long long currentFrame = 0;
+static scs_u64_t callbackAllocations = 0;
+static long long firstAllocationFrame = -1;
+static size_t firstAllocationSize = 0;
+
+static void note_allocation(const size_t size)
+{
+	if (!checkAllocations || !inCallback) {
+		return;
+	}
+	if (callbackAllocations++ == 0) {
+		firstAllocationFrame = currentFrame;
+		firstAllocationSize = size;
+	}
+}
+
+extern "C" void* malloc(size_t size)
+{
+	note_allocation(size);
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+	note_allocation(count * size);
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+	note_allocation(size);
+	return __libc_realloc(pointer, size);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size)
+{
+	note_allocation(size);
+	return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size)
+{
+	note_allocation(size);
+	return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** result, size_t alignment, size_t size)
+{
+	note_allocation(size);
+	*result = __libc_memalign(alignment, size);
+	return *result ? 0 : ENOMEM;
+}
+
+// Marks the calls into the plugin for the allocation check.
+struct callback_scope_t
+{
+	callback_scope_t() { inCallback = true; }
+	~callback_scope_t() { inCallback = false; }
+};
+#else
+struct callback_scope_t
+{
+};
+#endif
+
+// Upper bound of events accepted from a device in one frame before the host
+// assumes the callback never returns SCS_RESULT_not_found.
+const scs_u32_t maxEventsPerFrame = SCS_INPUT_MAX_INPUT_COUNT * 4;
+
+struct registered_device_t
+{
+	scs_input_device_t info;
+	std::string name;
+	std::string display_name;
+	std::vector<scs_input_device_input_t> inputs;
+	std::vector<std::string> input_names;
+	bool disconnected;
+};
+
+static std::vector<registered_device_t> devices;
+
+struct plugin_t
+{
+#ifdef _WIN32
+	HMODULE module;
+#else
+	void* module;
+#endif
+	scs_input_init_t input_init;
+	scs_input_shutdown_t input_shutdown;
+	scs_telemetry_init_t telemetry_init;
+	scs_telemetry_shutdown_t telemetry_shutdown;
+	set_clock_t set_clock;
+};
+
+static bool load_plugin(plugin_t& plugin, const char* const path)
+{
+	memset(&plugin, 0, sizeof(plugin));
+#ifdef _WIN32
+	plugin.module = LoadLibraryA(path);
+	if (!plugin.module) {
+		fprintf(stderr, "Unable to load %s\n", path);
+		return false;
+	}
+	plugin.input_init = reinterpret_cast<scs_input_init_t>(GetProcAddress(plugin.module, "scs_input_init"));
+	plugin.input_shutdown = reinterpret_cast<scs_input_shutdown_t>(GetProcAddress(plugin.module, "scs_input_shutdown"));
+	plugin.telemetry_init = reinterpret_cast<scs_telemetry_init_t>(GetProcAddress(plugin.module, "scs_telemetry_init"));
+	plugin.telemetry_shutdown = reinterpret_cast<scs_telemetry_shutdown_t>(GetProcAddress(plugin.module, "scs_telemetry_shutdown"));
+	plugin.set_clock = reinterpret_cast<set_clock_t>(GetProcAddress(plugin.module, "input_semantical_set_clock"));
+#else
+	plugin.module = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (!plugin.module) {
+		fprintf(stderr, "Unable to load %s: %s\n", path, dlerror());
+		return false;
+	}
+	plugin.input_init = reinterpret_cast<scs_input_init_t>(dlsym(plugin.module, "scs_input_init"));
+	plugin.input_shutdown = reinterpret_cast<scs_input_shutdown_t>(dlsym(plugin.module, "scs_input_shutdown"));
+	plugin.telemetry_init = reinterpret_cast<scs_telemetry_init_t>(dlsym(plugin.module, "scs_telemetry_init"));
+	plugin.telemetry_shutdown = reinterpret_cast<scs_telemetry_shutdown_t>(dlsym(plugin.module, "scs_telemetry_shutdown"));
+	plugin.set_clock = reinterpret_cast<set_clock_t>(dlsym(plugin.module, "input_semantical_set_clock"));
+#endif
+	if (!plugin.input_init) {
+		fprintf(stderr, "%s does not export scs_input_init\n", path);
+		return false;
+	}
+	return true;
+}
+
+static void unload_plugin(plugin_t& plugin)
+{
+#ifdef _WIN32
+	FreeLibrary(plugin.module);
+#else
+	dlclose(plugin.module);
+#endif
+	memset(&plugin, 0, sizeof(plugin));
+}
+
+// SDK side of the host.
+
+SCSAPI_VOID host_log(const scs_log_type_t type, const scs_string_t message)
+{
+	static const char* const prefixes[] = { "", "<warning> ", "<error> " };
+	fprintf(stderr, "[plugin] %s%s\n", (type >= 0 && type <= 2) ? prefixes[type] : "", message);
+}
+
+SCSAPI_RESULT host_register_device(const scs_input_device_t *const device_info)
+{
+	if (!device_info->name || !device_info->inputs || device_info->input_count == 0 || device_info->input_count > SCS_INPUT_MAX_INPUT_COUNT || !device_info->input_event_callback) {
+		return SCS_RESULT_invalid_parameter;
+	}
+	for (size_t i = 0; i < devices.size(); i++)
+	{
+		if (devices[i].name == device_info->name) {
+			return SCS_RESULT_already_registered;
+		}
+	}
+
+	// The structure is fully processed during the call, copy everything.
+	devices.push_back(registered_device_t());
+	registered_device_t& device = devices.back();
+	device.info = *device_info;
+	device.name = device_info->name;
+	device.display_name = device_info->display_name ? device_info->display_name : "";
+	device.input_names.resize(device_info->input_count);
+	device.inputs.assign(device_info->inputs, device_info->inputs + device_info->input_count);
+	for (scs_u32_t i = 0; i < device_info->input_count; i++)
+	{
+		if (!device.inputs[i].name) {
+			devices.pop_back();
+			return SCS_RESULT_invalid_parameter;
+		}
+		device.input_names[i] = device.inputs[i].name;
+		device.inputs[i].name = device.input_names[i].c_str();
+		device.inputs[i].display_name = NULL;
+	}
+	device.info.name = device.name.c_str();
+	device.info.display_name = device.display_name.c_str();
+	device.info.inputs = device.inputs.data();
+	device.disconnected = false;
+	return SCS_RESULT_ok;
+}
+
+// Telemetry side of the host. The truck follows the inputs the plugin
+// reported, which is enough for the controllers and the calibration to run.
+
+const scs_event_t telemetryEventCount = SCS_TELEMETRY_EVENT_gameplay + 1;
+
+struct telemetry_event_t
+{
+	scs_telemetry_event_callback_t callback;
+	scs_context_t context;
+};
+
+struct telemetry_channel_t
+{
+	std::string name;
+	scs_value_type_t type;
+	scs_telemetry_channel_callback_t callback;
+	scs_context_t context;
+};
+
+static telemetry_event_t telemetryEvents[telemetryEventCount];
+static std::vector<telemetry_channel_t> telemetryChannels;
+
+SCSAPI_RESULT host_register_for_event(const scs_event_t event, const scs_telemetry_event_callback_t callback, const scs_context_t context)
+{
+	if (event == SCS_TELEMETRY_EVENT_invalid || event >= telemetryEventCount || !callback) {
+		return SCS_RESULT_invalid_parameter;
+	}
+	if (telemetryEvents[event].callback) {
+		return SCS_RESULT_already_registered;
+	}
+	telemetryEvents[event].callback = callback;
+	telemetryEvents[event].context = context;
+	return SCS_RESULT_ok;
+}
+
+SCSAPI_RESULT host_unregister_from_event(const scs_event_t event)
+{
+	if (event >= telemetryEventCount || !telemetryEvents[event].callback) {
+		return SCS_RESULT_not_found;
+	}
+	telemetryEvents[event].callback = NULL;
+	return SCS_RESULT_ok;
+}
+
+SCSAPI_RESULT host_register_for_channel(const scs_string_t name, const scs_u32_t, const scs_value_type_t type, const scs_u32_t, const scs_telemetry_channel_callback_t callback, const scs_context_t context)
+{
+	if (!name || !callback) {
+		return SCS_RESULT_invalid_parameter;
+	}
+	telemetry_channel_t channel;
+	channel.name = name;
+	channel.type = type;
+	channel.callback = callback;
+	channel.context = context;
+	telemetryChannels.push_back(channel);
+	return SCS_RESULT_ok;
+}
+
+SCSAPI_RESULT host_unregister_from_channel(const scs_string_t name, const scs_u32_t, const scs_value_type_t type)
+{
+	for (size_t i = 0; i < telemetryChannels.size(); i++)
+	{
+		if (telemetryChannels[i].name == name && telemetryChannels[i].type == type) {
+			telemetryChannels.erase(telemetryChannels.begin() + i);
+			return SCS_RESULT_ok;
+		}
+	}
+	return SCS_RESULT_not_found;
+}
+
+static void send_telemetry_event(const scs_event_t event, const void* const info)
+{
+	if (telemetryEvents[event].callback) {
+		telemetryEvents[event].callback(event, info, telemetryEvents[event].context);
+	}
+}
+
+// Truck state derived from the last reported axes.
+struct truck_state_t
+{
+	float steering;
+	float throttle;
+	float brake;
+	float clutch;
+	float speed;
+	scs_u32_t game_time;
+};
+
+static void send_telemetry_frame(truck_state_t& truck, const scs_u64_t now, const scs_u64_t frame_time)
+{
+	scs_telemetry_frame_start_t start;
+	memset(&start, 0, sizeof(start));
+	start.render_time = now;
+	start.simulation_time = now;
+	start.paused_simulation_time = now;
+	send_telemetry_event(SCS_TELEMETRY_EVENT_frame_start, &start);
+
+	truck.speed += (truck.throttle * 2.0f - truck.brake * 6.0f) * frame_time / 1e6f;
+	truck.speed = truck.speed < 0.0f ? 0.0f : truck.speed;
+	truck.game_time = static_cast<scs_u32_t>(now / 60000000u);
+
+	for (const telemetry_channel_t& channel : telemetryChannels)
+	{
+		scs_value_t value;
+		memset(&value, 0, sizeof(value));
+		value.type = channel.type;
+		const std::string& name = channel.name;
+		if (channel.type == SCS_VALUE_TYPE_float) {
+			if (name == SCS_TELEMETRY_TRUCK_CHANNEL_speed) {
+				value.value_float.value = truck.speed;
+			}
+			else if (name == SCS_TELEMETRY_TRUCK_CHANNEL_input_steering || name == SCS_TELEMETRY_TRUCK_CHANNEL_effective_steering) {
+				value.value_float.value = truck.steering;
+			}
+			else if (name == SCS_TELEMETRY_TRUCK_CHANNEL_input_throttle || name == SCS_TELEMETRY_TRUCK_CHANNEL_effective_throttle) {
+				value.value_float.value = truck.throttle;
+			}
+			else if (name == SCS_TELEMETRY_TRUCK_CHANNEL_input_brake || name == SCS_TELEMETRY_TRUCK_CHANNEL_effective_brake) {
+				value.value_float.value = truck.brake;
+			}
+			else if (name == SCS_TELEMETRY_TRUCK_CHANNEL_input_clutch || name == SCS_TELEMETRY_TRUCK_CHANNEL_effective_clutch) {
+				value.value_float.value = truck.clutch;
+			}
+			else if (name == SCS_TELEMETRY_TRUCK_CHANNEL_engine_rpm) {
+				value.value_float.value = 800.0f + truck.speed * 50.0f;
+			}
+		}
+		else if (channel.type == SCS_VALUE_TYPE_s32) {
+			value.value_s32.value = truck.speed > 0.0f ? 1 : 0;
+		}
+		else if (channel.type == SCS_VALUE_TYPE_u32) {
+			value.value_u32.value = truck.game_time;
+		}
+		channel.callback(name.c_str(), SCS_U32_NIL, &value, channel.context);
+	}
+
+	send_telemetry_event(SCS_TELEMETRY_EVENT_frame_end, NULL);
+}
+
+// Replay of producer captures.
+
+struct capture_t
+{
+	scs_u32_t snapshot_size;
+	scs_u64_t start_time;
+	std::vector<scs_u64_t> times;
+	std::vector<unsigned char> snapshots;
+};
+
+static bool load_capture(capture_t& capture, const char* const path)
+{
+	FILE* const file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "Unable to open %s\n", path);
+		return false;
+	}
+
+	input_capture_header_t header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, inputCaptureMagic, sizeof(header.magic)) != 0 || header.version != inputCaptureVersion) {
+		fprintf(stderr, "%s is not an input capture\n", path);
+		fclose(file);
+		return false;
+	}
+
+	if (header.schema != layout_schema() || header.snapshot_size != producer_ranges_size()) {
+		fprintf(stderr, "%s was captured from a different control block layout\n", path);
+		fclose(file);
+		return false;
+	}
+
+	capture.snapshot_size = header.snapshot_size;
+	capture.start_time = header.start_time;
+	std::vector<unsigned char> snapshot(header.snapshot_size);
+	scs_u64_t time;
+	while (fread(&time, sizeof(time), 1, file) == 1 && fread(snapshot.data(), 1, snapshot.size(), file) == snapshot.size())
+	{
+		capture.times.push_back(time);
+		capture.snapshots.insert(capture.snapshots.end(), snapshot.begin(), snapshot.end());
+	}
+	fclose(file);
+	return true;
+}
+
+// The plugin reads its frame time from here during a replay, so timeouts
+// follow the capture and not the pacing of the run.
+static scs_u64_t virtualTime = 0;
+
+static scs_u64_t SCSAPIFUNC virtual_clock(void)
+{
+	return virtualTime;
+}
+
+// Output of the emitted events.
+
+static void append_u32(std::vector<unsigned char>& output, const scs_u32_t value)
+{
+	const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(&value);
+	output.insert(output.end(), bytes, bytes + sizeof(value));
+}
+
+static scs_u64_t fnv1a(const std::vector<unsigned char>& data)
+{
+	scs_u64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// Returns the frame of the first difference or -1 when equal.
+static long long compare_output(const std::vector<unsigned char>& output, const std::vector<unsigned char>& baseline)
+{
+	size_t offset = 0;
+	while (offset + 12 <= output.size() && offset + 12 <= baseline.size())
+	{
+		scs_u32_t frame;
+		scs_u32_t count;
+		memcpy(&frame, &output[offset], sizeof(frame));
+		memcpy(&count, &output[offset + 8], sizeof(count));
+		const size_t record = 12 + count * sizeof(scs_input_event_t);
+		if (offset + record > baseline.size() || memcmp(&output[offset], &baseline[offset], record) != 0) {
+			return frame;
+		}
+		offset += record;
+	}
+	if (output.size() != baseline.size()) {
+		scs_u32_t frame = 0;
+		if (offset + 4 <= output.size()) {
+			memcpy(&frame, &output[offset], sizeof(frame));
+		}
+		else if (offset + 4 <= baseline.size()) {
+			memcpy(&frame, &baseline[offset], sizeof(frame));
+		}
+		return frame;
+	}
+	return -1;
+}
+
+// The parts of the version 1 layout touched by the benchmark, at their old
+// offsets: fields of the producer and of the plugin shared cache lines.
+struct packed_frame_sync_t
+{
+	std::atomic<scs_u32_t> frame;
+	scs_u32_t _padding0;
+	std::atomic<scs_u64_t> frame_time;
+	std::atomic<scs_u32_t> lockstep;
+	std::atomic<scs_u32_t> lockstep_timeout;
+	std::atomic<scs_u32_t> ack_frame;
+	scs_u32_t _padding1;
+	std::atomic<scs_u32_t> lockstep_waits;
+	std::atomic<scs_u32_t> lockstep_misses;
+	std::atomic<scs_u32_t> wait_histogram[lockstepHistogramBuckets];
+};
+
+struct packed_producer_slot_t
+{
+	std::atomic<scs_u32_t> sequence;
+	std::atomic<scs_u32_t> id;
+	scs_u32_t priority;
+	std::atomic<scs_u32_t> heartbeat;
+	scs_u64_t ownership;
+	float axes[axisCount];
+	bool buttons[buttonCount];
+	scs_u8_t groups[input_group_count];
+	char _padding[7];
+	scs_u64_t granted;
+	std::atomic<scs_u32_t> live;
+	scs_u32_t _padding1;
+};
+
+struct alignas(cacheLineSize) packed_block_t
+{
+	char legacy[64];
+	packed_frame_sync_t sync;
+	char _other[1904 - 64 - sizeof(packed_frame_sync_t)];
+	packed_producer_slot_t producers[producerSlotCount];
+};
+
+static_assert(offsetof(packed_frame_sync_t, lockstep_waits) == 32, "not the version 1 layout");
+static_assert(offsetof(packed_producer_slot_t, granted) == 88, "not the version 1 layout");
+static_assert(sizeof(packed_producer_slot_t) == 104, "not the version 1 layout");
+static_assert(offsetof(packed_block_t, producers) == 1904, "not the version 1 layout");
+
+static control_block_t benchAligned;
+static packed_block_t benchPacked;
+
+struct layout_bench_t
+{
+	scs_u64_t producer_rounds;
+	scs_u64_t plugin_rounds;
+	scs_u64_t retries;			// seqlock reads of the plugin repeated
+};
+
+// The producer commits its slot and acknowledges the frame, the plugin
+// starts frames, reads the slot and grants it, as fast as they can.
+template <typename block_t>
+static layout_bench_t run_layout_bench(block_t& block, const scs_u64_t duration)
+{
+	layout_bench_t result;
+	memset(&result, 0, sizeof(result));
+	std::atomic<bool> running(true);
+
+	std::thread producer([&]() {
+		auto& slot = block.producers[0];
+		scs_u64_t rounds = 0;
+		while (running.load(std::memory_order_relaxed))
+		{
+			const scs_u32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+			slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			slot.ownership = rounds;
+			slot.axes[0] = static_cast<float>(rounds & 0xff) / 255.0f;
+			slot.sequence.store(sequence + 2, std::memory_order_release);
+			slot.heartbeat.store(static_cast<scs_u32_t>(rounds), std::memory_order_relaxed);
+			block.sync.ack_frame.store(block.sync.frame.load(std::memory_order_acquire), std::memory_order_release);
+			rounds++;
+		}
+		result.producer_rounds = rounds;
+	});
+
+	std::thread plugin([&]() {
+		auto& slot = block.producers[0];
+		scs_u64_t rounds = 0;
+		scs_u64_t retries = 0;
+		while (running.load(std::memory_order_relaxed))
+		{
+			block.sync.frame.store(static_cast<scs_u32_t>(rounds + 1), std::memory_order_release);
+			block.sync.frame_time.store(rounds, std::memory_order_relaxed);
+
+			scs_u64_t ownership;
+			for (;;)
+			{
+				const scs_u32_t before = slot.sequence.load(std::memory_order_acquire);
+				ownership = slot.ownership;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (!(before & 1) && slot.sequence.load(std::memory_order_relaxed) == before) {
+					break;
+				}
+				retries++;
+			}
+
+			slot.granted = ownership;
+			slot.live.store(1, std::memory_order_relaxed);
+			block.sync.lockstep_waits.fetch_add(1, std::memory_order_relaxed);
+			rounds++;
+		}
+		result.plugin_rounds = rounds;
+		result.retries = retries;
+	});
+
+	sleep_us(duration);
+	running.store(false);
+	producer.join();
+	plugin.join();
+	return result;
+}
+
+static void print_layout_bench(const char* const name, const layout_bench_t& result, const scs_u64_t duration)
+{
+	const double seconds = duration / 1e6;
+	printf("%-14s %14.0f %14.0f %12llu\n", name, result.producer_rounds / seconds, result.plugin_rounds / seconds,
+		static_cast<unsigned long long>(result.retries));
+}
+
+static int layout_bench(const double seconds)
+{
+	const scs_u64_t duration = static_cast<scs_u64_t>(seconds * 1e6);
+	if (std::thread::hardware_concurrency() < 2) {
+		printf("Only one CPU, the threads never run at once and both layouts perform alike.\n");
+	}
+	printf("%-14s %14s %14s %12s\n", "layout", "producer/s", "plugin/s", "retries");
+
+	// Alternating, so frequency changes affect both alike.
+	layout_bench_t packed;
+	layout_bench_t aligned;
+	memset(&packed, 0, sizeof(packed));
+	memset(&aligned, 0, sizeof(aligned));
+	for (int round = 0; round < 4; round++)
+	{
+		const layout_bench_t p = run_layout_bench(benchPacked, duration / 4);
+		const layout_bench_t a = run_layout_bench(benchAligned, duration / 4);
+		packed.producer_rounds += p.producer_rounds;
+		packed.plugin_rounds += p.plugin_rounds;
+		packed.retries += p.retries;
+		aligned.producer_rounds += a.producer_rounds;
+		aligned.plugin_rounds += a.plugin_rounds;
+		aligned.retries += a.retries;
+	}
+	print_layout_bench("packed (v1)", packed, duration);
+	print_layout_bench("aligned (v2)", aligned, duration);
+	return 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: fake_host <plugin> [options]\n"
+		"       fake_host --layout-bench [seconds]\n"
+		"  --game <eut2|ats>     game id passed to the plugin (default eut2)\n"
+		"  --replay <capture>    feed the control block from an input_capture file\n"
+		"  --fps <n>             frames per second of the virtual clock (default 60)\n"
+		"  --speed <x>           replay speed, 1 = realtime, 0 = as fast as possible (default 1)\n"
+		"  --frames <n>          number of frames (default: length of the capture + 1 s)\n"
+		"  --output <file>       write the emitted events\n"
+		"  --compare <file>      compare the emitted events with a previous --output\n"
+		"  --text                print the emitted events\n"
+		"  --telemetry           drive the telemetry API of the plugin too\n"
+		"  --check-allocations   fail when a callback allocates heap memory\n");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2 && strcmp(argv[1], "--layout-bench") == 0) {
+		const double seconds = argc > 2 ? atof(argv[2]) : 4.0;
+		if (seconds <= 0.0) {
+			usage();
+			return 1;
+		}
+		return layout_bench(seconds);
+	}
+	if (argc < 2 || argv[1][0] == '-') {
+		usage();
+		return 1;
+	}
+
+	const char* const plugin_path = argv[1];
+	std::string game = SCS_GAME_ID_EUT2;
+	const char* replay_path = NULL;
+	const char* output_path = NULL;
+	const char* compare_path = NULL;
+	double fps = 60.0;
+	double speed = 1.0;
+	long long frames = -1;
+	bool text = false;
+	bool drive_telemetry = false;
+
+	for (int i = 2; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		const bool has_value = (i + 1 < argc);
+		if (argument == "--game" && has_value) {
+			game = argv[++i];
+		}
+		else if (argument == "--replay" && has_value) {
+			replay_path = argv[++i];
+		}
+		else if (argument == "--fps" && has_value) {
+			fps = atof(argv[++i]);
+		}
+		else if (argument == "--speed" && has_value) {
+			speed = atof(argv[++i]);
+		}
+		else if (argument == "--frames" && has_value) {
+			frames = atoll(argv[++i]);
+		}
+		else if (argument == "--output" && has_value) {
+			output_path = argv[++i];
+		}
+		else if (argument == "--compare" && has_value) {
+			compare_path = argv[++i];
+		}
+		else if (argument == "--text") {
+			text = true;
+		}
+		else if (argument == "--telemetry") {
+			drive_telemetry = true;
+		}
+		else if (argument == "--check-allocations") {
+#ifdef ALLOCATION_CHECK
+			checkAllocations = true;
+#else
+			fprintf(stderr, "--check-allocations needs glibc\n");
+			return 1;
+#endif
+		}
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (fps <= 0.0 || speed < 0.0) {
+		usage();
+		return 1;
+	}
+
+	capture_t capture;
+	if (replay_path && !load_capture(capture, replay_path)) {
+		return 1;
+	}
+	const scs_u64_t frame_time = static_cast<scs_u64_t>(1e6 / fps);
+	if (frames < 0) {
+		const scs_u64_t length = capture.times.empty() ? 0 : capture.times.back();
+		frames = static_cast<long long>((length + 1000000) / frame_time);
+	}
+
+	plugin_t plugin;
+	if (!load_plugin(plugin, plugin_path)) {
+		return 1;
+	}
+	if (replay_path) {
+		virtualTime = capture.start_time;
+		if (plugin.set_clock) {
+			plugin.set_clock(virtual_clock);
+		}
+		else {
+			fprintf(stderr, "%s does not export input_semantical_set_clock, the replay follows the wall clock\n", plugin_path);
+		}
+	}
+
+	if (drive_telemetry) {
+		scs_telemetry_init_params_v101_t telemetry_params;
+		memset(&telemetry_params, 0, sizeof(telemetry_params));
+		telemetry_params.common.game_name = (game == SCS_GAME_ID_ATS) ? "American Truck Simulator" : "Euro Truck Simulator 2";
+		telemetry_params.common.game_id = game.c_str();
+		telemetry_params.common.game_version = (game == SCS_GAME_ID_ATS) ? SCS_TELEMETRY_ATS_GAME_VERSION_CURRENT : SCS_TELEMETRY_EUT2_GAME_VERSION_CURRENT;
+		telemetry_params.common.log = host_log;
+		telemetry_params.register_for_event = host_register_for_event;
+		telemetry_params.unregister_from_event = host_unregister_from_event;
+		telemetry_params.register_for_channel = host_register_for_channel;
+		telemetry_params.unregister_from_channel = host_unregister_from_channel;
+		if (!plugin.telemetry_init || plugin.telemetry_init(SCS_TELEMETRY_VERSION_1_01, &telemetry_params) != SCS_RESULT_ok) {
+			fprintf(stderr, "scs_telemetry_init failed\n");
+			unload_plugin(plugin);
+			return 1;
+		}
+	}
+
+	scs_input_init_params_v100_t params;
+	memset(&params, 0, sizeof(params));
+	params.common.game_name = (game == SCS_GAME_ID_ATS) ? "American Truck Simulator" : "Euro Truck Simulator 2";
+	params.common.game_id = game.c_str();
+	params.common.game_version = (game == SCS_GAME_ID_ATS) ? SCS_INPUT_ATS_GAME_VERSION_CURRENT : SCS_INPUT_EUT2_GAME_VERSION_CURRENT;
+	params.common.log = host_log;
+	params.register_device = host_register_device;
+
+	if (plugin.input_init(SCS_INPUT_VERSION_1_00, &params) != SCS_RESULT_ok) {
+		fprintf(stderr, "scs_input_init failed\n");
+		unload_plugin(plugin);
+		return 1;
+	}
+	if (devices.empty()) {
+		fprintf(stderr, "The plugin did not register any device\n");
+	}
+
+	// The plugin runs in this process, its registry entry names the block.
+	const char* name = memname;
+	instance_info_t instances[registryEntryCount];
+	const int instance_count = instance_registry_list(instances, registryEntryCount);
+	for (int i = 0; i < instance_count; i++)
+	{
+		if (instances[i].pid == process_id()) {
+			name = instances[i].name;
+		}
+	}
+
+	shared_memory_t memory;
+	if (!shared_memory_open(memory, name, memsize)) {
+		fprintf(stderr, "The plugin did not create %s\n", name);
+	}
+
+	const control_block_t* const block = static_cast<const control_block_t*>(memory.data);
+
+	std::vector<unsigned char> output;
+	size_t next_entry = 0;
+	scs_u64_t callback_time = 0;
+	scs_u64_t event_count = 0;
+	const scs_u64_t started = monotonic_time_us();
+
+	truck_state_t truck;
+	memset(&truck, 0, sizeof(truck));
+
+	// The devices are active and the simulation runs for the whole run.
+	{
+		callback_scope_t scope;
+		for (size_t d = 0; d < devices.size(); d++)
+		{
+			if (devices[d].info.input_active_callback) {
+				devices[d].info.input_active_callback(1, devices[d].info.callback_context);
+			}
+		}
+		send_telemetry_event(SCS_TELEMETRY_EVENT_started, NULL);
+	}
+
+	for (long long frame = 0; frame < frames; frame++)
+	{
+		const scs_u64_t now = static_cast<scs_u64_t>(frame) * frame_time;
+		virtualTime = capture.start_time + now;
+#ifdef ALLOCATION_CHECK
+		currentFrame = frame;
+#endif
+
+		// Apply everything the producers wrote up to this frame.
+		while (next_entry < capture.times.size() && capture.times[next_entry] <= now)
+		{
+			if (memory.data) {
+				capture_scatter(memory.data, &capture.snapshots[next_entry * capture.snapshot_size]);
+			}
+			next_entry++;
+		}
+
+		if (speed > 0.0) {
+			const scs_u64_t due = started + static_cast<scs_u64_t>(now / speed);
+			const scs_u64_t wall = monotonic_time_us();
+			if (due > wall) {
+				sleep_us(due - wall);
+			}
+		}
+
+		if (drive_telemetry) {
+			callback_scope_t scope;
+			send_telemetry_frame(truck, now, frame_time);
+		}
+
+		for (size_t d = 0; d < devices.size(); d++)
+		{
+			registered_device_t& device = devices[d];
+			if (device.disconnected) {
+				continue;
+			}
+
+			const size_t record = output.size();
+			append_u32(output, static_cast<scs_u32_t>(frame));
+			append_u32(output, static_cast<scs_u32_t>(d));
+			append_u32(output, 0);
+
+			scs_u32_t flags = SCS_INPUT_EVENT_CALLBACK_FLAG_first_in_frame;
+			if (frame == 0) {
+				flags |= SCS_INPUT_EVENT_CALLBACK_FLAG_first_after_activation;
+			}
+
+			scs_u32_t count = 0;
+			for (;;)
+			{
+				scs_input_event_t event;
+				memset(&event, 0, sizeof(event));
+
+				const scs_u64_t before = monotonic_time_us();
+				scs_result_t result;
+				{
+					callback_scope_t scope;
+					result = device.info.input_event_callback(&event, flags, device.info.callback_context);
+				}
+				callback_time += monotonic_time_us() - before;
+				flags = 0;
+
+				if (result == SCS_RESULT_not_found) {
+					break;
+				}
+				if (result != SCS_RESULT_ok) {
+					fprintf(stderr, "Device %s returned %d in frame %lld and was disconnected\n", device.name.c_str(), result, frame);
+					device.disconnected = true;
+					break;
+				}
+				if (event.input_index >= device.info.input_count) {
+					fprintf(stderr, "Device %s sent event for invalid input %u in frame %lld\n", device.name.c_str(), event.input_index, frame);
+				}
+				if (++count > maxEventsPerFrame) {
+					fprintf(stderr, "Device %s did not finish frame %lld\n", device.name.c_str(), frame);
+					device.disconnected = true;
+					break;
+				}
+
+				const unsigned char* const bytes = reinterpret_cast<const unsigned char*>(&event);
+				output.insert(output.end(), bytes, bytes + sizeof(event));
+
+				if (event.input_index < device.info.input_count && device.inputs[event.input_index].value_type == SCS_VALUE_TYPE_float) {
+					const std::string& input = device.input_names[event.input_index];
+					float* const target = input == "steering" ? &truck.steering : input == "aforward" ? &truck.throttle : input == "abackward" ? &truck.brake : input == "clutch" ? &truck.clutch : NULL;
+					if (target) {
+						*target = event.value_float.value;
+					}
+				}
+
+				if (text && event.input_index < device.info.input_count) {
+					const scs_input_device_input_t& input = device.inputs[event.input_index];
+					if (input.value_type == SCS_VALUE_TYPE_float) {
+						printf("%lld %s.%s %f\n", frame, device.name.c_str(), input.name, event.value_float.value);
+					}
+					else {
+						printf("%lld %s.%s %u\n", frame, device.name.c_str(), input.name, event.value_bool.value);
+					}
+				}
+			}
+			memcpy(&output[record + 8], &count, sizeof(count));
+			event_count += count;
+		}
+	}
+
+	const scs_u64_t elapsed = monotonic_time_us() - started;
+
+	{
+		callback_scope_t scope;
+		send_telemetry_event(SCS_TELEMETRY_EVENT_paused, NULL);
+		for (size_t d = 0; d < devices.size(); d++)
+		{
+			if (devices[d].info.input_active_callback && !devices[d].disconnected) {
+				devices[d].info.input_active_callback(0, devices[d].info.callback_context);
+			}
+		}
+	}
+
+	if (block && block->sync.lockstep_waits.load()) {
+		fprintf(stderr, "lockstep: %u waits, %u misses, wait histogram (us):", block->sync.lockstep_waits.load(), block->sync.lockstep_misses.load());
+		for (int i = 0; i < lockstepHistogramBuckets; i++)
+		{
+			const scs_u32_t count = block->sync.wait_histogram[i].load();
+			if (count) {
+				fprintf(stderr, " <%u:%u", (2u << i) - 1, count);
+			}
+		}
+		fprintf(stderr, "\n");
+	}
+
+	if (plugin.input_shutdown) {
+		plugin.input_shutdown();
+	}
+	if (drive_telemetry && plugin.telemetry_shutdown) {
+		plugin.telemetry_shutdown();
+	}
+	if (plugin.set_clock) {
+		plugin.set_clock(NULL);
+	}
+	devices.clear();
+	shared_memory_close(memory);
+	unload_plugin(plugin);
+
+	const double simulated = static_cast<double>(frames) * frame_time / 1e6;
+	fprintf(stderr, "%lld frames, %llu events, %.3f s simulated in %.3f s (%.1fx realtime), %.3f us in callbacks per frame\n",
+		frames, static_cast<unsigned long long>(event_count), simulated, elapsed / 1e6,
+		elapsed ? simulated * 1e6 / elapsed : 0.0, frames ? static_cast<double>(callback_time) / frames : 0.0);
+	fprintf(stderr, "output hash %016llx\n", static_cast<unsigned long long>(fnv1a(output)));
+
+	if (output_path) {
+		FILE* const file = fopen(output_path, "wb");
+		if (!file || fwrite(output.data(), 1, output.size(), file) != output.size()) {
+			fprintf(stderr, "Unable to write %s\n", output_path);
+			return 1;
+		}
+		fclose(file);
+	}
+
+	if (compare_path) {
+		FILE* const file = fopen(compare_path, "rb");
+		if (!file) {
+			fprintf(stderr, "Unable to open %s\n", compare_path);
+			return 1;
+		}
+		std::vector<unsigned char> baseline;
+		unsigned char buffer[65536];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			baseline.insert(baseline.end(), buffer, buffer + read);
+		}
+		fclose(file);
+
+		const long long difference = compare_output(output, baseline);
+		if (difference >= 0) {
+			fprintf(stderr, "Output differs from %s starting at frame %lld\n", compare_path, difference);
+			return 2;
+		}
+		fprintf(stderr, "Output matches %s\n", compare_path);
+	}
+
+#ifdef ALLOCATION_CHECK
+	if (checkAllocations) {
+		if (callbackAllocations) {
+			fprintf(stderr, "%llu allocations in callbacks, the first of %zu bytes in frame %lld\n",
+				static_cast<unsigned long long>(callbackAllocations), firstAllocationSize, firstAllocationFrame);
+			return 3;
+		}
+		fprintf(stderr, "No allocations in callbacks\n");
+	}
+#endif
+
+	return 0;
+}
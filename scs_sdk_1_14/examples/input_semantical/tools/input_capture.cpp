@@ -0,0 +1,152 @@
+/**
+ * @brief Captures what the producers write into the control block.
+ *
+ * Polls the producer ranges of the shared memory at a fixed rate and stores
+ * every changed snapshot with its timestamp. The result can be replayed into the plugin with
+ * fake_host --replay.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../control_layout.h"
+#include "../instance_registry.h"
+#include "../platform.h"
+#include "input_capture_format.h"
+
+static volatile sig_atomic_t stopCapture = 0;
+
+static void on_signal(int)
+{
+	stopCapture = 1;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: input_capture [options] <output>\n"
+		"  --name <name>       shared memory name (default %s)\n"
+		"  --game <id>         capture the first running instance of this game\n"
+		"  --list              list the running instances and exit\n"
+		"  --rate <hz>         polling rate (default 1000)\n"
+		"  --duration <s>      stop after this many seconds (default: until Ctrl+C)\n",
+		memname);
+}
+
+int main(int argc, char** argv)
+{
+	const char* name = memname;
+	const char* output = NULL;
+	double rate = 1000.0;
+	double duration = 0.0;
+	instance_info_t instances[registryEntryCount];
+	const int instance_count = instance_registry_list(instances, registryEntryCount);
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		const bool has_value = (i + 1 < argc);
+		if (argument == "--name" && has_value) {
+			name = argv[++i];
+		}
+		else if (argument == "--game" && has_value) {
+			const char* const game = argv[++i];
+			name = NULL;
+			for (int j = 0; j < instance_count && !name; j++)
+			{
+				if (strcmp(instances[j].game_id, game) == 0) {
+					name = instances[j].name;
+				}
+			}
+			if (!name) {
+				fprintf(stderr, "No running instance of %s\n", game);
+				return 1;
+			}
+		}
+		else if (argument == "--list") {
+			for (int j = 0; j < instance_count; j++)
+			{
+				const instance_info_t& instance = instances[j];
+				printf("%u %s %u.%u %s\n", instance.pid, instance.game_id, instance.game_version >> 16, instance.game_version & 0xffff, instance.name);
+			}
+			return 0;
+		}
+		else if (argument == "--rate" && has_value) {
+			rate = atof(argv[++i]);
+		}
+		else if (argument == "--duration" && has_value) {
+			duration = atof(argv[++i]);
+		}
+		else if (argument[0] == '-' || output) {
+			usage();
+			return 1;
+		}
+		else {
+			output = argv[i];
+		}
+	}
+	if (!output || rate <= 0.0) {
+		usage();
+		return 1;
+	}
+
+	shared_memory_t memory;
+	if (!shared_memory_open(memory, name, memsize)) {
+		fprintf(stderr, "Unable to open %s, is the game running?\n", name);
+		return 1;
+	}
+
+	FILE* const file = fopen(output, "wb");
+	if (!file) {
+		fprintf(stderr, "Unable to create %s\n", output);
+		shared_memory_close(memory);
+		return 1;
+	}
+
+	input_capture_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, inputCaptureMagic, sizeof(header.magic));
+	header.version = inputCaptureVersion;
+	const scs_u64_t start = monotonic_time_us();
+	header.snapshot_size = static_cast<scs_u32_t>(producer_ranges_size());
+	header.start_time = start;
+	header.schema = layout_schema();
+	fwrite(&header, sizeof(header), 1, file);
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	std::vector<unsigned char> previous(header.snapshot_size);
+	std::vector<unsigned char> current(header.snapshot_size);
+	const scs_u64_t period = static_cast<scs_u64_t>(1e6 / rate);
+	const scs_u64_t end = duration > 0.0 ? start + static_cast<scs_u64_t>(duration * 1e6) : ~static_cast<scs_u64_t>(0);
+	unsigned long long entries = 0;
+
+	while (!stopCapture)
+	{
+		const scs_u64_t now = monotonic_time_us();
+		if (now >= end) {
+			break;
+		}
+
+		capture_gather(current.data(), memory.data);
+		if (entries == 0 || current != previous) {
+			const scs_u64_t time = now - start;
+			fwrite(&time, sizeof(time), 1, file);
+			fwrite(current.data(), 1, current.size(), file);
+			previous.swap(current);
+			entries++;
+		}
+
+		sleep_us(period);
+	}
+
+	fclose(file);
+	shared_memory_close(memory);
+	fprintf(stderr, "Captured %llu snapshots\n", entries);
+	return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * @brief Format of the producer input captures.
+ *
+ * A header followed by entries, each being a u64 timestamp (microseconds
+ * since the start of the capture) and the producerRanges of the control
+ * block packed in order, as the producers left them. An entry is only
+ * written when one of the ranges changed, the plugin-written rest of the
+ * block is neither recorded nor restored. schema is the layout_schema()
+ * of the block the capture was taken from.
+ *
+ * start_time is monotonic_time_us() at the start of the capture, the clock
+ * of the trajectory_knot_t::time values the producers wrote into the block,
+ * so a replay can put the plugin clock on the same base.
+ */
+#ifndef INPUT_SEMANTICAL_INPUT_CAPTURE_FORMAT_H
+#define INPUT_SEMANTICAL_INPUT_CAPTURE_FORMAT_H
+
+#include <string.h>
+
+#include "scssdk.h"
+#include "../control_layout.h"
+
+const char inputCaptureMagic[8] = { 'S', 'C', 'S', 'C', 'A', 'P', '1', '\0' };
+const scs_u32_t inputCaptureVersion = 3;
+
+#pragma pack(push, 1)
+
+struct input_capture_header_t
+{
+	char magic[8];
+	scs_u32_t version;
+	scs_u32_t snapshot_size;		// producer_ranges_size()
+	scs_u64_t start_time;
+	scs_u32_t schema;
+	scs_u32_t _reserved;
+};
+
+#pragma pack(pop)
+
+// Copies the producer ranges of block into snapshot.
+inline void capture_gather(unsigned char* snapshot, const void* const block)
+{
+	const unsigned char* const bytes = static_cast<const unsigned char*>(block);
+	for (int i = 0; i < producerRangeCount; i++)
+	{
+		const block_range_t& range = producerRanges[i];
+		for (size_t j = 0; j < range.count; j++)
+		{
+			memcpy(snapshot, bytes + range.offset + j * range.stride, range.size);
+			snapshot += range.size;
+		}
+	}
+}
+
+// Writes a snapshot back into the producer ranges of block.
+inline void capture_scatter(void* const block, const unsigned char* snapshot)
+{
+	unsigned char* const bytes = static_cast<unsigned char*>(block);
+	for (int i = 0; i < producerRangeCount; i++)
+	{
+		const block_range_t& range = producerRanges[i];
+		for (size_t j = 0; j < range.count; j++)
+		{
+			memcpy(bytes + range.offset + j * range.stride, snapshot, range.size);
+			snapshot += range.size;
+		}
+	}
+}
+
+#endif // INPUT_SEMANTICAL_INPUT_CAPTURE_FORMAT_H
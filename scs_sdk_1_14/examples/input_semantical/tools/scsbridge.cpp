@@ -0,0 +1,658 @@
+/**
+ * @brief Forwards producer frames received over a socket into the control block.
+ *
+ * For producers which can not map the shared memory, e.g. because they run
+ * in a container. Frames (client/scs_bridge.h) arrive over loopback UDP or,
+ * outside of Windows, a Unix domain datagram socket which can be mounted
+ * into the container. Every wakeup of the event loop (epoll on Linux, an
+ * I/O completion port on Windows, poll elsewhere) reads all pending
+ * datagrams at once and applies them to one producer slot per producer id
+ * between a single scs_client_begin and scs_client_commit, so a burst costs
+ * one commit per producer.
+ *
+ * Counters and the arrival to commit latency are published in
+ * control_block_t::bridge and shown by scsctl stats.
+ */
+
+#ifdef _WIN32
+#  define WINVER 0x0600
+#  define _WIN32_WINNT 0x0600
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#  include <windows.h>
+#  pragma comment(lib, "ws2_32.lib")
+#else
+#  include <arpa/inet.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <sys/un.h>
+#  include <time.h>
+#  include <unistd.h>
+#  ifdef __linux__
+#    include <sys/epoll.h>
+#  else
+#    include <poll.h>
+#  endif
+#endif
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "../client/scs_bridge.h"
+#include "../client/scs_client.h"
+#include "../control_layout.h"
+#include "../instance_registry.h"
+#include "../platform.h"
+#include "../stats.h"
+
+const int batchCapacity = 64;
+
+struct datagram_t
+{
+	scs_bridge_frame_t frame;
+	int size;
+	scs_u64_t received;		// bridge_time_us of the arrival
+};
+
+struct producer_t
+{
+	scs_client_t client;
+	scs_u32_t id;			// 0 = unused
+	scs_u32_t sequence;
+	scs_u64_t last_frame;		// monotonic_time_us
+	bool closing;
+};
+
+static producer_t producers[producerSlotCount];
+static volatile sig_atomic_t running = 1;
+
+static void stop(int)
+{
+	running = 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: scsbridge [--name <name> | --game <id>] [--udp [<address>:]<port>]"
+#ifndef _WIN32
+		" [--unix <path>]"
+#endif
+		" [--idle <ms>] [--verbose]\n"
+		"  --udp      listen for frames on UDP, default %s:%u without --unix\n"
+#ifndef _WIN32
+		"  --unix     listen for frames on a Unix domain datagram socket, e.g. %s\n"
+#endif
+		"  --idle     free the slot of a producer silent for that long, default 5000\n"
+		"  --verbose  print the counters every second\n",
+		"127.0.0.1", scsBridgeDefaultPort
+#ifndef _WIN32
+		, scsBridgeDefaultSocket
+#endif
+	);
+}
+
+// Clock of the datagram arrival times. On Linux the kernel stamps the
+// datagrams with the real time clock.
+static scs_u64_t bridge_time_us(void)
+{
+#ifdef __linux__
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return static_cast<scs_u64_t>(now.tv_sec) * 1000000u + now.tv_nsec / 1000;
+#else
+	return monotonic_time_us();
+#endif
+}
+
+static bool parse_endpoint(const char* const text, sockaddr_in& address)
+{
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	const char* port = text;
+	const char* const colon = strrchr(text, ':');
+	if (colon) {
+		const std::string host(text, colon);
+		if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+			return false;
+		}
+		port = colon + 1;
+	}
+	const int number = atoi(port);
+	if (number <= 0 || number > 65535) {
+		return false;
+	}
+	address.sin_port = htons(static_cast<unsigned short>(number));
+	return true;
+}
+
+#ifdef _WIN32
+
+// One outstanding overlapped receive, reposted after every completion.
+struct receive_t
+{
+	OVERLAPPED overlapped;
+	WSABUF buffer;
+	DWORD flags;
+	sockaddr_in from;
+	int from_size;
+	char data[sizeof(scs_bridge_frame_t) + 1];
+};
+
+struct listener_t
+{
+	SOCKET udp;
+	HANDLE port;
+	receive_t receives[batchCapacity];
+};
+
+static bool post_receive(listener_t& listener, receive_t& receive)
+{
+	memset(&receive.overlapped, 0, sizeof(receive.overlapped));
+	receive.buffer.buf = receive.data;
+	receive.buffer.len = sizeof(receive.data);
+	receive.flags = 0;
+	receive.from_size = sizeof(receive.from);
+	if (WSARecvFrom(listener.udp, &receive.buffer, 1, NULL, &receive.flags, reinterpret_cast<sockaddr*>(&receive.from), &receive.from_size, &receive.overlapped, NULL) != 0) {
+		return WSAGetLastError() == WSA_IO_PENDING;
+	}
+	return true;
+}
+
+static bool listener_open(listener_t& listener, const sockaddr_in* const udp, const char* const)
+{
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+		return false;
+	}
+	listener.udp = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_OVERLAPPED);
+	if (listener.udp == INVALID_SOCKET || bind(listener.udp, reinterpret_cast<const sockaddr*>(udp), sizeof(*udp)) != 0) {
+		fprintf(stderr, "Could not listen on UDP port %u (%d)\n", ntohs(udp->sin_port), WSAGetLastError());
+		return false;
+	}
+	listener.port = CreateIoCompletionPort(reinterpret_cast<HANDLE>(listener.udp), NULL, 0, 1);
+	if (listener.port == NULL) {
+		return false;
+	}
+	for (int i = 0; i < batchCapacity; i++)
+	{
+		if (!post_receive(listener, listener.receives[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Waits for datagrams and takes every completion already queued.
+static int listener_wait(listener_t& listener, datagram_t* const datagrams, const int capacity, const int timeout)
+{
+	OVERLAPPED_ENTRY entries[batchCapacity];
+	ULONG count = 0;
+	if (!GetQueuedCompletionStatusEx(listener.port, entries, static_cast<ULONG>(capacity), &count, static_cast<DWORD>(timeout), FALSE)) {
+		return 0;
+	}
+	const scs_u64_t now = bridge_time_us();
+	for (ULONG i = 0; i < count; i++)
+	{
+		receive_t& receive = *CONTAINING_RECORD(entries[i].lpOverlapped, receive_t, overlapped);
+		datagram_t& datagram = datagrams[i];
+		datagram.size = static_cast<int>(entries[i].dwNumberOfBytesTransferred);
+		datagram.received = now;
+		if (datagram.size == sizeof(datagram.frame)) {
+			memcpy(&datagram.frame, receive.data, sizeof(datagram.frame));
+		}
+		post_receive(listener, receive);
+	}
+	return static_cast<int>(count);
+}
+
+static void listener_close(listener_t& listener)
+{
+	closesocket(listener.udp);
+	CloseHandle(listener.port);
+	WSACleanup();
+}
+
+#else
+
+struct listener_t
+{
+	int sockets[2];
+	int count;
+	const char* unix_path;
+#ifdef __linux__
+	int epoll;
+#endif
+};
+
+static int open_socket(const int family)
+{
+	const int result = socket(family, SOCK_DGRAM, 0);
+	if (result < 0) {
+		return -1;
+	}
+	fcntl(result, F_SETFL, fcntl(result, F_GETFL) | O_NONBLOCK);
+#ifdef __linux__
+	const int enable = 1;
+	setsockopt(result, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+#endif
+	return result;
+}
+
+static bool listener_open(listener_t& listener, const sockaddr_in* const udp, const char* const unix_path)
+{
+	listener.count = 0;
+	listener.unix_path = NULL;
+	if (udp) {
+		const int udp_socket = open_socket(AF_INET);
+		if (udp_socket < 0 || bind(udp_socket, reinterpret_cast<const sockaddr*>(udp), sizeof(*udp)) != 0) {
+			fprintf(stderr, "Could not listen on UDP port %u: %s\n", ntohs(udp->sin_port), strerror(errno));
+			return false;
+		}
+		listener.sockets[listener.count++] = udp_socket;
+	}
+	if (unix_path) {
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (strlen(unix_path) >= sizeof(address.sun_path)) {
+			fprintf(stderr, "Socket path %s is too long\n", unix_path);
+			return false;
+		}
+		strcpy(address.sun_path, unix_path);
+		unlink(unix_path);
+		const int unix_socket = open_socket(AF_UNIX);
+		if (unix_socket < 0 || bind(unix_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+			fprintf(stderr, "Could not listen on %s: %s\n", unix_path, strerror(errno));
+			return false;
+		}
+		// Containers usually run the producer under another user.
+		chmod(unix_path, 0666);
+		listener.sockets[listener.count++] = unix_socket;
+		listener.unix_path = unix_path;
+	}
+#ifdef __linux__
+	listener.epoll = epoll_create1(0);
+	for (int i = 0; i < listener.count; i++)
+	{
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = listener.sockets[i];
+		if (epoll_ctl(listener.epoll, EPOLL_CTL_ADD, listener.sockets[i], &event) != 0) {
+			return false;
+		}
+	}
+#endif
+	return true;
+}
+
+// Reads the pending datagrams of a ready socket.
+static int receive_batch(const int socket, datagram_t* const datagrams, const int capacity)
+{
+#ifdef __linux__
+	char data[batchCapacity][sizeof(scs_bridge_frame_t) + 1];
+	char controls[batchCapacity][CMSG_SPACE(sizeof(struct timespec))];
+	struct iovec vectors[batchCapacity];
+	struct mmsghdr messages[batchCapacity];
+	memset(messages, 0, sizeof(messages[0]) * capacity);
+	for (int i = 0; i < capacity; i++)
+	{
+		vectors[i].iov_base = data[i];
+		vectors[i].iov_len = sizeof(data[i]);
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+		messages[i].msg_hdr.msg_control = controls[i];
+		messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+	}
+	const int count = recvmmsg(socket, messages, capacity, MSG_DONTWAIT, NULL);
+	if (count <= 0) {
+		return 0;
+	}
+	const scs_u64_t now = bridge_time_us();
+	for (int i = 0; i < count; i++)
+	{
+		datagram_t& datagram = datagrams[i];
+		datagram.size = static_cast<int>(messages[i].msg_len);
+		datagram.received = now;
+		if (datagram.size == sizeof(datagram.frame)) {
+			memcpy(&datagram.frame, data[i], sizeof(datagram.frame));
+		}
+		for (struct cmsghdr* control = CMSG_FIRSTHDR(&messages[i].msg_hdr); control; control = CMSG_NXTHDR(&messages[i].msg_hdr, control))
+		{
+			if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS) {
+				struct timespec stamp;
+				memcpy(&stamp, CMSG_DATA(control), sizeof(stamp));
+				datagram.received = static_cast<scs_u64_t>(stamp.tv_sec) * 1000000u + stamp.tv_nsec / 1000;
+			}
+		}
+	}
+	return count;
+#else
+	int count = 0;
+	char data[sizeof(scs_bridge_frame_t) + 1];
+	for (; count < capacity; count++)
+	{
+		const ssize_t size = recv(socket, data, sizeof(data), 0);
+		if (size < 0) {
+			break;
+		}
+		datagram_t& datagram = datagrams[count];
+		datagram.size = static_cast<int>(size);
+		datagram.received = bridge_time_us();
+		if (datagram.size == sizeof(datagram.frame)) {
+			memcpy(&datagram.frame, data, sizeof(datagram.frame));
+		}
+	}
+	return count;
+#endif
+}
+
+static int listener_wait(listener_t& listener, datagram_t* const datagrams, const int capacity, const int timeout)
+{
+	int count = 0;
+#ifdef __linux__
+	struct epoll_event events[2];
+	const int ready = epoll_wait(listener.epoll, events, 2, timeout);
+	for (int i = 0; i < ready; i++)
+	{
+		count += receive_batch(events[i].data.fd, datagrams + count, capacity - count);
+	}
+#else
+	struct pollfd descriptors[2];
+	for (int i = 0; i < listener.count; i++)
+	{
+		descriptors[i].fd = listener.sockets[i];
+		descriptors[i].events = POLLIN;
+		descriptors[i].revents = 0;
+	}
+	if (poll(descriptors, listener.count, timeout) > 0) {
+		for (int i = 0; i < listener.count; i++)
+		{
+			if (descriptors[i].revents & POLLIN) {
+				count += receive_batch(descriptors[i].fd, datagrams + count, capacity - count);
+			}
+		}
+	}
+#endif
+	return count;
+}
+
+static void listener_close(listener_t& listener)
+{
+	for (int i = 0; i < listener.count; i++)
+	{
+		close(listener.sockets[i]);
+	}
+#ifdef __linux__
+	close(listener.epoll);
+#endif
+	if (listener.unix_path) {
+		unlink(listener.unix_path);
+	}
+}
+
+#endif
+
+static producer_t* find_producer(const char* const name, const scs_bridge_frame_t& frame)
+{
+	producer_t* free_entry = NULL;
+	for (producer_t& producer : producers)
+	{
+		if (producer.id == frame.producer) {
+			return &producer;
+		}
+		if (producer.id == 0 && !free_entry) {
+			free_entry = &producer;
+		}
+	}
+	if (!free_entry || scs_client_open(free_entry->client, name, frame.producer, frame.priority) != scs_client_ok) {
+		return NULL;
+	}
+	free_entry->id = frame.producer;
+	free_entry->sequence = frame.sequence - 1;
+	free_entry->closing = false;
+	return free_entry;
+}
+
+static void close_producer(producer_t& producer)
+{
+	scs_client_close(producer.client);
+	producer.id = 0;
+}
+
+static void apply_frame(producer_t& producer, const scs_bridge_frame_t& frame)
+{
+	scs_client_t& client = producer.client;
+	scs_client_begin(client);
+	client.slot->priority = frame.priority;
+	scs_client_release(client, frame.release);
+	for (int i = 0; i < axisCount; i++)
+	{
+		if (frame.axis_mask & (1u << i)) {
+			scs_client_set_axis(client, static_cast<axis_t>(i), frame.axes[i]);
+		}
+	}
+	if (frame.button_mask) {
+		scs_client_set_buttons(client, frame.button_mask, frame.pressed);
+	}
+	for (int i = 0; i < input_group_count; i++)
+	{
+		if ((frame.group_mask & (1u << i)) && frame.groups[i] <= inputGroupRanges[i].count) {
+			scs_client_set_group(client, static_cast<input_group_t>(i), frame.groups[i]);
+		}
+	}
+	if (frame.flags & scs_bridge_flag_close) {
+		producer.closing = true;
+	}
+}
+
+// Applies a batch with one commit per producer, returns the number of accepted datagrams.
+static int apply_batch(const char* const name, const datagram_t* const datagrams, const int count, bridge_stats_t& stats, scs_u32_t* const interval)
+{
+	int accepted = 0;
+	bool applied[batchCapacity];
+	const scs_u64_t now = monotonic_time_us();
+	for (int i = 0; i < count; i++)
+	{
+		const scs_bridge_frame_t& frame = datagrams[i].frame;
+		applied[i] = false;
+		if (datagrams[i].size != sizeof(frame) || frame.magic != scsBridgeMagic || frame.producer == 0) {
+			continue;
+		}
+		producer_t* const producer = find_producer(name, frame);
+		if (!producer || static_cast<scs_s32_t>(frame.sequence - producer->sequence) <= 0) {
+			continue;
+		}
+		producer->sequence = frame.sequence;
+		producer->last_frame = now;
+		apply_frame(*producer, frame);
+		applied[i] = true;
+		accepted++;
+	}
+
+	int commits = 0;
+	for (producer_t& producer : producers)
+	{
+		if (producer.id == 0 || !producer.client.writing) {
+			continue;
+		}
+		scs_client_commit(producer.client);
+		commits++;
+		if (producer.closing) {
+			close_producer(producer);
+		}
+	}
+
+	const scs_u64_t committed = bridge_time_us();
+	for (int i = 0; i < count; i++)
+	{
+		if (!applied[i]) {
+			continue;
+		}
+		const scs_u64_t latency = committed > datagrams[i].received ? committed - datagrams[i].received : 0;
+		const int bucket = stats_bucket(latency, statsHistogramBuckets);
+		stats.latency_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+		interval[bucket]++;
+	}
+	stats.datagrams.fetch_add(count, std::memory_order_relaxed);
+	stats.dropped.fetch_add(count - accepted, std::memory_order_relaxed);
+	stats.batches.fetch_add(1, std::memory_order_relaxed);
+	stats.commits.fetch_add(commits, std::memory_order_relaxed);
+	return accepted;
+}
+
+// Upper bound in microseconds of the histogram bucket holding the given share.
+static scs_u32_t percentile(const scs_u32_t* const buckets, const double share)
+{
+	scs_u64_t total = 0;
+	for (int i = 0; i < statsHistogramBuckets; i++)
+	{
+		total += buckets[i];
+	}
+	scs_u64_t seen = 0;
+	for (int i = 0; i < statsHistogramBuckets && total; i++)
+	{
+		seen += buckets[i];
+		if (seen >= share * total) {
+			return (1u << (i + 1)) - 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::string name = memname;
+	sockaddr_in udp_address;
+	bool udp = false;
+	const char* unix_path = NULL;
+	scs_u64_t idle = 5000000;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		const bool has_value = i + 1 < argc;
+		if (option == "--name" && has_value) {
+			name = argv[++i];
+		}
+		else if (option == "--game" && has_value) {
+			instance_info_t instances[registryEntryCount];
+			const int count = instance_registry_list(instances, registryEntryCount);
+			const char* const game_id = argv[++i];
+			int found = -1;
+			for (int j = 0; j < count && found < 0; j++)
+			{
+				if (strcmp(instances[j].game_id, game_id) == 0) {
+					found = j;
+				}
+			}
+			if (found < 0) {
+				fprintf(stderr, "No running instance of %s\n", game_id);
+				return 1;
+			}
+			name = instances[found].name;
+		}
+		else if (option == "--udp" && has_value) {
+			if (!parse_endpoint(argv[++i], udp_address)) {
+				fprintf(stderr, "Bad UDP endpoint %s\n", argv[i]);
+				return 1;
+			}
+			udp = true;
+		}
+#ifndef _WIN32
+		else if (option == "--unix" && has_value) {
+			unix_path = argv[++i];
+		}
+#endif
+		else if (option == "--idle" && has_value) {
+			idle = static_cast<scs_u64_t>(atoi(argv[++i])) * 1000;
+		}
+		else if (option == "--verbose") {
+			verbose = true;
+		}
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (!udp && !unix_path) {
+		char endpoint[32];
+		snprintf(endpoint, sizeof(endpoint), "%u", scsBridgeDefaultPort);
+		parse_endpoint(endpoint, udp_address);
+		udp = true;
+	}
+
+	scs_client_t monitor;
+	const scs_client_status_t status = scs_client_attach(monitor, name.c_str());
+	if (status != scs_client_ok) {
+		fprintf(stderr, status == scs_client_not_found ? "No control block %s\n" : "The plugin behind %s uses another layout than this tool\n", name.c_str());
+		return 1;
+	}
+	bridge_stats_t& stats = monitor.block->bridge;
+	const scs_u32_t other = stats.pid.load();
+	if (other != 0 && other != process_id() && process_alive(other)) {
+		fprintf(stderr, "Bridge %u already serves %s\n", other, name.c_str());
+		scs_client_unmap(monitor);
+		return 1;
+	}
+
+	listener_t listener;
+	if (!listener_open(listener, udp ? &udp_address : NULL, unix_path)) {
+		scs_client_unmap(monitor);
+		return 1;
+	}
+	stats.pid.store(process_id(), std::memory_order_release);
+	signal(SIGINT, stop);
+	signal(SIGTERM, stop);
+
+	datagram_t datagrams[batchCapacity];
+	scs_u32_t interval[statsHistogramBuckets] = {};
+	scs_u64_t next_report = monotonic_time_us() + 1000000;
+	while (running)
+	{
+		const int count = listener_wait(listener, datagrams, batchCapacity, 100);
+		if (count > 0) {
+			apply_batch(name.c_str(), datagrams, count, stats, interval);
+		}
+
+		const scs_u64_t now = monotonic_time_us();
+		if (now < next_report) {
+			continue;
+		}
+		next_report = now + 1000000;
+		stats.p50_latency.store(percentile(interval, 0.5), std::memory_order_relaxed);
+		stats.p99_latency.store(percentile(interval, 0.99), std::memory_order_relaxed);
+		memset(interval, 0, sizeof(interval));
+		for (producer_t& producer : producers)
+		{
+			if (producer.id != 0 && now - producer.last_frame > idle) {
+				close_producer(producer);
+			}
+		}
+		if (verbose) {
+			printf("datagrams %u, dropped %u, batches %u, commits %u, latency p50 < %u us, p99 < %u us\n",
+				stats.datagrams.load(), stats.dropped.load(), stats.batches.load(), stats.commits.load(),
+				stats.p50_latency.load(), stats.p99_latency.load());
+			fflush(stdout);
+		}
+	}
+
+	for (producer_t& producer : producers)
+	{
+		if (producer.id != 0) {
+			close_producer(producer);
+		}
+	}
+	listener_close(listener);
+	stats.pid.store(0, std::memory_order_release);
+	scs_client_unmap(monitor);
+	return 0;
+}
@@ -0,0 +1,598 @@
+/**
+ * @brief Inspects and drives the control block of a running plugin.
+ *
+ * Attaches to the block by name (or finds it in the instance registry by
+ * game) and can print it, set inputs in the shared part at offset 0, follow
+ * the changes frame by frame, show the plugin statistics and load the
+ * transport from several producer threads.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../client/scs_client.h"
+#include "../control_layout.h"
+#include "../instance_registry.h"
+#include "../platform.h"
+
+static const char* const groupNames[input_group_count] = { "wipers", "camera", "gear" };
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: scsctl [--name <name> | --game <id>] <command> [options]\n"
+		"  dump                           print the control block\n"
+		"  schema                         print the layout of the control block\n"
+		"  set <input>=<value>...         set inputs in the shared block, groups as group.<name>=<n>,\n"
+		"                                 generic inputs as generic.axis<i> or generic.button<i>\n"
+		"  tail [--frames <n>]            print the changes frame by frame\n"
+		"  stats [--watch]                print the plugin statistics, every second with --watch\n"
+		"  bench [--threads <n>] [--rate <hz>] [--duration <s>] [--own]\n"
+		"                                 commit from n producer slots (default 4 threads, 1000 Hz, 5 s),\n"
+		"                                 the inputs are only taken over with --own\n");
+}
+
+static int find_input(const char* const name)
+{
+	for (int i = 0; i < inputCount; i++)
+	{
+		if (strcmp(inputNames[i], name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Upper bound in microseconds of the bucket holding the given share of a log2 histogram.
+static scs_u64_t histogram_percentile(const std::atomic<scs_u32_t>* const buckets, const int count, const double share)
+{
+	scs_u64_t total = 0;
+	for (int i = 0; i < count; i++)
+	{
+		total += buckets[i].load(std::memory_order_relaxed);
+	}
+	if (total == 0) {
+		return 0;
+	}
+	scs_u64_t seen = 0;
+	for (int i = 0; i < count; i++)
+	{
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= share * total) {
+			return (scs_u64_t(1) << (i + 1)) - 1;
+		}
+	}
+	return (scs_u64_t(1) << count) - 1;
+}
+
+static void print_histogram(const char* const title, const std::atomic<scs_u32_t>* const buckets, const int count)
+{
+	printf("%s (us): p50 < %llu, p99 < %llu\n", title,
+		static_cast<unsigned long long>(histogram_percentile(buckets, count, 0.5)),
+		static_cast<unsigned long long>(histogram_percentile(buckets, count, 0.99)));
+	for (int i = 0; i < count; i++)
+	{
+		const scs_u32_t value = buckets[i].load(std::memory_order_relaxed);
+		if (value) {
+			printf("  [%6llu, %6llu) %u\n", static_cast<unsigned long long>((scs_u64_t(1) << i) - 1), static_cast<unsigned long long>((scs_u64_t(1) << (i + 1)) - 1), value);
+		}
+	}
+}
+
+static int command_dump(const control_block_t& block)
+{
+	const layout_info_t& layout = block.layout;
+	printf("layout version %u, %u bytes, schema %08x\n", layout.version, layout.size, layout.schema);
+	printf("frame %u, heartbeat %u, activity %s%s\n",
+		block.sync.frame.load(), block.heartbeat.load(),
+		(block.activity.state.load() & activity_device_active) ? "device " : "",
+		(block.activity.state.load() & activity_game_running) ? "running" : "paused");
+	printf("lockstep %s, ack %u\n", block.sync.lockstep.load() ? "on" : "off", block.sync.ack_frame.load());
+
+	printf("axes:");
+	for (int i = 0; i < axisCount; i++)
+	{
+		printf(" %s %.3f", inputNames[i], block.axes[i]);
+	}
+	printf("\nbuttons:");
+	int pressed = 0;
+	for (int i = 0; i < buttonCount; i++)
+	{
+		if (block.buttons[i]) {
+			printf(" %s", inputNames[axisCount + i]);
+			pressed++;
+		}
+	}
+	printf(pressed ? "\ngroups:" : " none\ngroups:");
+	for (int i = 0; i < input_group_count; i++)
+	{
+		printf(" %s %u", groupNames[i], block.groups[i]);
+	}
+	printf("\n");
+
+	for (int i = 0; i < producerSlotCount; i++)
+	{
+		const producer_slot_t& slot = block.producers[i];
+		if (slot.id.load() == 0) {
+			continue;
+		}
+		printf("producer %d: id %u, priority %u, %s, heartbeat %u, owns %011llx, granted %011llx\n",
+			i, slot.id.load(), slot.priority, slot.live.load() ? "live" : "stale", slot.heartbeat.load(),
+			static_cast<unsigned long long>(slot.ownership), static_cast<unsigned long long>(slot.granted));
+	}
+
+	printf("override: active %x, takeovers %u, authority %.2f %.2f\n", block.human_override.active.load(), block.human_override.takeovers.load(),
+		block.human_override.authority[0], block.human_override.authority[1]);
+	printf("calibration: state %u, samples %u, cells %u\n", block.calibration.state.load(), block.calibration.samples.load(), block.calibration.filled_cells.load());
+	printf("macros: queued %u, started %u, finished %u, running %u\n", block.macros.tail.load(), block.macros.head.load(), block.macros.executed.load(), block.macros.running.load());
+	printf("trajectory: %s, samples %u\n", block.trajectory.enabled.load() ? "enabled" : "disabled", block.trajectory.samples.load());
+
+	const telemetry_values_t& telemetry = block.telemetry.values;
+	printf("telemetry: frame %u, %s, speed %.2f m/s, rpm %.0f, gear %d, steering %.3f/%.3f, throttle %.3f/%.3f, brake %.3f/%.3f\n",
+		telemetry.frames, telemetry.paused ? "paused" : "running", telemetry.speed, telemetry.rpm, telemetry.gear,
+		telemetry.input_steering, telemetry.effective_steering, telemetry.input_throttle, telemetry.effective_throttle,
+		telemetry.input_brake, telemetry.effective_brake);
+	return 0;
+}
+
+#define REGION(field) { #field, offsetof(control_block_t, field), sizeof(control_block_t::field) }
+
+static int command_schema(void)
+{
+	struct region_t
+	{
+		const char* name;
+		size_t offset;
+		size_t size;
+	};
+	const region_t regions[] = {
+		REGION(axes), REGION(buttons), REGION(heartbeat), REGION(groups), REGION(sync),
+		REGION(trajectory), REGION(controller), REGION(producers), REGION(human_override),
+		REGION(calibration), REGION(macros), REGION(activity), REGION(layout), REGION(telemetry),
+		REGION(stats), REGION(bridge), REGION(generic)
+	};
+	printf("layout version %u, %zu bytes, schema %08x\n", layoutVersion, memsize, layout_schema());
+	printf("%-16s %6s %6s\n", "region", "offset", "size");
+	for (const region_t& region : regions)
+	{
+		printf("%-16s %6zu %6zu\n", region.name, region.offset, region.size);
+	}
+	printf("inputs:");
+	for (int i = 0; i < inputCount; i++)
+	{
+		printf(" %d=%s", i, inputNames[i]);
+	}
+	printf("\n");
+	return 0;
+}
+
+static int command_set(control_block_t& block, const std::vector<std::string>& assignments)
+{
+	for (const std::string& assignment : assignments)
+	{
+		const size_t equals = assignment.find('=');
+		if (equals == std::string::npos) {
+			fprintf(stderr, "Expected <input>=<value>, got %s\n", assignment.c_str());
+			return 1;
+		}
+		const std::string name = assignment.substr(0, equals);
+		const double value = atof(assignment.c_str() + equals + 1);
+
+		if (name.compare(0, 6, "group.") == 0) {
+			int group = 0;
+			while (group < input_group_count && name.compare(6, std::string::npos, groupNames[group]) != 0)
+			{
+				group++;
+			}
+			if (group == input_group_count || value < 0 || value > inputGroupRanges[group].count) {
+				fprintf(stderr, "Bad group assignment %s\n", assignment.c_str());
+				return 1;
+			}
+			block.groups[group] = static_cast<scs_u8_t>(value);
+			continue;
+		}
+
+		int index;
+		char extra;
+		if (sscanf(name.c_str(), "generic.axis%d%c", &index, &extra) == 1 && index >= 0 && index < genericAxisCount) {
+			block.generic.axes[index] = static_cast<float>(value);
+			continue;
+		}
+		if (sscanf(name.c_str(), "generic.button%d%c", &index, &extra) == 1 && index >= 0 && index < genericButtonCount) {
+			block.generic.buttons[index] = value != 0.0;
+			continue;
+		}
+
+		const int input = find_input(name.c_str());
+		if (input < 0) {
+			fprintf(stderr, "Unknown input %s\n", name.c_str());
+			return 1;
+		}
+		if (input < axisCount) {
+			block.axes[input] = static_cast<float>(value);
+		}
+		else {
+			block.buttons[input - axisCount] = value != 0.0;
+		}
+	}
+	block.heartbeat.fetch_add(1, std::memory_order_release);
+	return 0;
+}
+
+// Everything tail compares from frame to frame.
+struct tail_state_t
+{
+	float axes[axisCount];
+	bool buttons[buttonCount];
+	scs_u8_t groups[input_group_count];
+	scs_u32_t live[producerSlotCount];
+	scs_u64_t granted[producerSlotCount];
+	scs_u32_t activity;
+	scs_u32_t override_active;
+	scs_u32_t macros_finished;
+	scs_u32_t calibration;
+	scs_u32_t lockstep_misses;
+	scs_u32_t torn_reads;
+	scs_u32_t failsafe_frames;
+};
+
+static void tail_capture(const control_block_t& block, tail_state_t& state)
+{
+	memcpy(state.axes, block.axes, sizeof(state.axes));
+	memcpy(state.buttons, block.buttons, sizeof(state.buttons));
+	memcpy(state.groups, block.groups, sizeof(state.groups));
+	for (int i = 0; i < producerSlotCount; i++)
+	{
+		state.live[i] = block.producers[i].live.load(std::memory_order_relaxed);
+		state.granted[i] = block.producers[i].granted;
+	}
+	state.activity = block.activity.state.load(std::memory_order_relaxed);
+	state.override_active = block.human_override.active.load(std::memory_order_relaxed);
+	state.macros_finished = block.macros.executed.load(std::memory_order_relaxed);
+	state.calibration = block.calibration.state.load(std::memory_order_relaxed);
+	state.lockstep_misses = block.sync.lockstep_misses.load(std::memory_order_relaxed);
+	state.torn_reads = block.stats.torn_reads.load(std::memory_order_relaxed);
+	state.failsafe_frames = block.stats.failsafe_frames.load(std::memory_order_relaxed);
+}
+
+static int command_tail(scs_client_t& client, const long long frames)
+{
+	tail_state_t previous;
+	tail_state_t current;
+	tail_capture(*client.block, previous);
+	bool failsafe = false;
+
+	for (long long count = 0; frames == 0 || count < frames; count++)
+	{
+		const scs_u32_t frame = scs_client_wait_frame(client, 1000000);
+		if (!frame) {
+			printf("no frame for 1 s\n");
+			continue;
+		}
+		tail_capture(*client.block, current);
+
+		for (int i = 0; i < axisCount; i++)
+		{
+			if (current.axes[i] != previous.axes[i]) {
+				printf("%u %s %.3f\n", frame, inputNames[i], current.axes[i]);
+			}
+		}
+		for (int i = 0; i < buttonCount; i++)
+		{
+			if (current.buttons[i] != previous.buttons[i]) {
+				printf("%u %s %d\n", frame, inputNames[axisCount + i], current.buttons[i]);
+			}
+		}
+		for (int i = 0; i < input_group_count; i++)
+		{
+			if (current.groups[i] != previous.groups[i]) {
+				printf("%u group.%s %u\n", frame, groupNames[i], current.groups[i]);
+			}
+		}
+		for (int i = 0; i < producerSlotCount; i++)
+		{
+			if (current.live[i] != previous.live[i]) {
+				printf("%u producer %d %s\n", frame, i, current.live[i] ? "live" : "stale");
+			}
+			if (current.granted[i] != previous.granted[i]) {
+				printf("%u producer %d granted %011llx\n", frame, i, static_cast<unsigned long long>(current.granted[i]));
+			}
+		}
+		if (current.activity != previous.activity) {
+			printf("%u activity %u\n", frame, current.activity);
+		}
+		if (current.override_active != previous.override_active) {
+			printf("%u override %x\n", frame, current.override_active);
+		}
+		if (current.macros_finished != previous.macros_finished) {
+			printf("%u macros finished %u\n", frame, current.macros_finished - previous.macros_finished);
+		}
+		if (current.calibration != previous.calibration) {
+			printf("%u calibration state %u\n", frame, current.calibration);
+		}
+		if (current.lockstep_misses != previous.lockstep_misses) {
+			printf("%u lockstep misses %u\n", frame, current.lockstep_misses - previous.lockstep_misses);
+		}
+		if (current.torn_reads != previous.torn_reads) {
+			printf("%u torn reads %u\n", frame, current.torn_reads - previous.torn_reads);
+		}
+		if ((current.failsafe_frames != previous.failsafe_frames) != failsafe) {
+			failsafe = !failsafe;
+			printf("%u fail-safe %s\n", frame, failsafe ? "on" : "off");
+		}
+		fflush(stdout);
+		previous = current;
+	}
+	return 0;
+}
+
+static void print_stats(const control_block_t& block)
+{
+	const stats_t& stats = block.stats;
+	printf("frames %u, stale %u, torn reads %u, fail-safe %u\n", stats.frames.load(), stats.stale_frames.load(), stats.torn_reads.load(), stats.failsafe_frames.load());
+	print_histogram("frame processing", stats.processing_histogram, statsHistogramBuckets);
+	const scs_u32_t memory = stats.memory_flags.load();
+	printf("memory: %u pages prepared in %u us%s%s%s, %u page faults in %u frames\n", stats.prepared_pages.load(), stats.prepare_time.load(),
+		(memory & memory_flag_locked) ? ", locked" : "", (memory & memory_flag_lock_failed) ? ", locking failed" : "",
+		(memory & memory_flag_large_pages) ? ", large pages" : "", stats.page_faults.load(), stats.faulting_frames.load());
+	printf("lockstep waits %u, misses %u\n", block.sync.lockstep_waits.load(), block.sync.lockstep_misses.load());
+	print_histogram("lockstep wait", block.sync.wait_histogram, lockstepHistogramBuckets);
+	printf("trajectory samples %u, torn reads %u, extrapolated %u\n", block.trajectory.samples.load(), block.trajectory.torn_reads.load(), block.trajectory.extrapolated.load());
+	int live = 0;
+	for (int i = 0; i < producerSlotCount; i++)
+	{
+		live += block.producers[i].live.load() ? 1 : 0;
+	}
+	printf("live producers %d, override takeovers %u, macros finished %u\n", live, block.human_override.takeovers.load(), block.macros.executed.load());
+	const bridge_stats_t& bridge = block.bridge;
+	if (bridge.pid.load()) {
+		printf("bridge %u: datagrams %u, dropped %u, batches %u, commits %u, latency p50 < %u us, p99 < %u us\n",
+			bridge.pid.load(), bridge.datagrams.load(), bridge.dropped.load(), bridge.batches.load(), bridge.commits.load(),
+			bridge.p50_latency.load(), bridge.p99_latency.load());
+		print_histogram("bridge latency", bridge.latency_histogram, statsHistogramBuckets);
+	}
+}
+
+static int command_stats(const control_block_t& block, const bool watch)
+{
+	if (!watch) {
+		print_stats(block);
+		return 0;
+	}
+	scs_u32_t frames = block.stats.frames.load();
+	scs_u32_t stale = block.stats.stale_frames.load();
+	scs_u32_t torn = block.stats.torn_reads.load();
+	for (;;)
+	{
+		sleep_us(1000000);
+		const scs_u32_t now_frames = block.stats.frames.load();
+		const scs_u32_t now_stale = block.stats.stale_frames.load();
+		const scs_u32_t now_torn = block.stats.torn_reads.load();
+		printf("\n%u frames/s, %u stale/s, %u torn reads/s\n", now_frames - frames, now_stale - stale, now_torn - torn);
+		print_stats(block);
+		fflush(stdout);
+		frames = now_frames;
+		stale = now_stale;
+		torn = now_torn;
+	}
+}
+
+struct bench_result_t
+{
+	scs_u64_t commits = 0;
+	scs_u64_t histogram[32] = {};	// commit duration, bucket i = [2^i - 1, 2^(i+1) - 1) ns
+	scs_u64_t maximum = 0;
+	scs_client_status_t status = scs_client_ok;
+};
+
+static void bench_thread(const std::string name, const int index, const double rate, const double duration, const bool own, bench_result_t& result)
+{
+	scs_client_t client;
+	result.status = scs_client_open(client, name.c_str(), 0x5c5c0000u + index, 0);
+	if (result.status != scs_client_ok) {
+		return;
+	}
+
+	typedef std::chrono::steady_clock clock;
+	const clock::time_point start = clock::now();
+	const clock::time_point end = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(duration));
+	const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(rate > 0 ? 1.0 / rate : 0.0));
+	clock::time_point next = start;
+	const scs_u64_t allInputs = (scs_u64_t(1) << inputCount) - 1;
+
+	for (scs_u64_t n = 0; clock::now() < end; n++)
+	{
+		const clock::time_point before = clock::now();
+		scs_client_begin(client);
+		scs_client_set_axis(client, axis_steering, 0.5f * sinf(n * 0.01f));
+		scs_client_set_axis(client, axis_aforward, 0.0f);
+		scs_client_set_buttons(client, (scs_u64_t(1) << buttonCount) - 1, n);
+		if (!own) {
+			scs_client_release(client, allInputs);
+		}
+		scs_client_commit(client);
+		const scs_u64_t took = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - before).count();
+
+		int bucket = 0;
+		for (scs_u64_t limit = took + 1; limit > 1 && bucket < 31; limit >>= 1)
+		{
+			bucket++;
+		}
+		result.histogram[bucket]++;
+		result.maximum = took > result.maximum ? took : result.maximum;
+		result.commits++;
+
+		if (rate > 0) {
+			next += period;
+			std::this_thread::sleep_until(next);
+		}
+	}
+	scs_client_close(client);
+}
+
+static int command_bench(const std::string& name, control_block_t& block, const int threads, const double rate, const double duration, const bool own)
+{
+	if (threads < 1 || threads > producerSlotCount) {
+		fprintf(stderr, "Between 1 and %d threads, one per producer slot\n", producerSlotCount);
+		return 1;
+	}
+	const scs_u32_t frames = block.stats.frames.load();
+	const scs_u32_t torn = block.stats.torn_reads.load();
+	const scs_u32_t stale = block.stats.stale_frames.load();
+
+	std::vector<bench_result_t> results(threads);
+	std::vector<std::thread> workers;
+	for (int i = 0; i < threads; i++)
+	{
+		workers.emplace_back(bench_thread, name, i, rate, duration, own, std::ref(results[i]));
+	}
+	bench_result_t total;
+	for (int i = 0; i < threads; i++)
+	{
+		workers[i].join();
+		if (results[i].status != scs_client_ok) {
+			fprintf(stderr, "Thread %d could not open a producer slot (%d)\n", i, results[i].status);
+			continue;
+		}
+		total.commits += results[i].commits;
+		total.maximum = results[i].maximum > total.maximum ? results[i].maximum : total.maximum;
+		for (int j = 0; j < 32; j++)
+		{
+			total.histogram[j] += results[i].histogram[j];
+		}
+	}
+
+	scs_u64_t p50 = 0;
+	scs_u64_t p99 = 0;
+	scs_u64_t seen = 0;
+	for (int j = 0; j < 32; j++)
+	{
+		seen += total.histogram[j];
+		if (!p50 && seen >= total.commits * 0.5) {
+			p50 = (scs_u64_t(1) << (j + 1)) - 1;
+		}
+		if (!p99 && seen >= total.commits * 0.99) {
+			p99 = (scs_u64_t(1) << (j + 1)) - 1;
+		}
+	}
+	printf("%d threads, %llu commits in %.1f s (%.0f/s), commit p50 < %llu ns, p99 < %llu ns, max %llu ns\n",
+		threads, static_cast<unsigned long long>(total.commits), duration, total.commits / duration,
+		static_cast<unsigned long long>(p50), static_cast<unsigned long long>(p99), static_cast<unsigned long long>(total.maximum));
+	printf("plugin: %u frames, %u torn reads, %u stale frames\n",
+		block.stats.frames.load() - frames, block.stats.torn_reads.load() - torn, block.stats.stale_frames.load() - stale);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::string name = memname;
+	int first = 1;
+	for (; first + 1 < argc && argv[first][0] == '-'; first += 2)
+	{
+		const std::string option = argv[first];
+		if (option == "--name") {
+			name = argv[first + 1];
+		}
+		else if (option == "--game") {
+			instance_info_t instances[registryEntryCount];
+			const int count = instance_registry_list(instances, registryEntryCount);
+			int found = -1;
+			for (int i = 0; i < count && found < 0; i++)
+			{
+				if (strcmp(instances[i].game_id, argv[first + 1]) == 0) {
+					found = i;
+				}
+			}
+			if (found < 0) {
+				fprintf(stderr, "No running instance of %s\n", argv[first + 1]);
+				return 1;
+			}
+			name = instances[found].name;
+		}
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (first >= argc) {
+		usage();
+		return 1;
+	}
+	const std::string command = argv[first];
+	if (command == "schema") {
+		return command_schema();
+	}
+
+	scs_client_t client;
+	const scs_client_status_t status = scs_client_attach(client, name.c_str());
+	if (status == scs_client_not_found) {
+		fprintf(stderr, "No control block %s\n", name.c_str());
+		return 1;
+	}
+	if (status == scs_client_bad_layout) {
+		fprintf(stderr, "The plugin uses another layout than this tool (schema %08x)\n", layout_schema());
+		return 1;
+	}
+	control_block_t& block = *client.block;
+
+	int result = 0;
+	if (command == "dump") {
+		result = command_dump(block);
+	}
+	else if (command == "set") {
+		result = command_set(block, std::vector<std::string>(argv + first + 1, argv + argc));
+	}
+	else if (command == "tail") {
+		long long frames = 0;
+		if (first + 2 < argc && strcmp(argv[first + 1], "--frames") == 0) {
+			frames = atoll(argv[first + 2]);
+		}
+		result = command_tail(client, frames);
+	}
+	else if (command == "stats") {
+		result = command_stats(block, first + 1 < argc && strcmp(argv[first + 1], "--watch") == 0);
+	}
+	else if (command == "bench") {
+		int threads = 4;
+		double rate = 1000.0;
+		double duration = 5.0;
+		bool own = false;
+		for (int i = first + 1; i < argc; i++)
+		{
+			const std::string option = argv[i];
+			const bool has_value = i + 1 < argc;
+			if (option == "--threads" && has_value) {
+				threads = atoi(argv[++i]);
+			}
+			else if (option == "--rate" && has_value) {
+				rate = atof(argv[++i]);
+			}
+			else if (option == "--duration" && has_value) {
+				duration = atof(argv[++i]);
+			}
+			else if (option == "--own") {
+				own = true;
+			}
+			else {
+				usage();
+				result = 1;
+			}
+		}
+		if (result == 0) {
+			result = command_bench(name, block, threads, rate, duration, own);
+		}
+	}
+	else {
+		usage();
+		result = 1;
+	}
+	scs_client_unmap(client);
+	return result;
+}
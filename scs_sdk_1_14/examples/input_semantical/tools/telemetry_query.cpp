@@ -0,0 +1,495 @@
+/**
+ * @brief Parallel query tool over telemetry recordings.
+ *
+ * Scans any number of recordings (see recording_format.h) on all cores. The
+ * chunk footers are used to skip chunks outside of the time window or whose
+ * min/max cannot satisfy the filter, and the footer index seeks to the first
+ * sample of the window inside the chunks which are read.
+ *
+ * Example, every moment above 90 km/h with the wheel turned right:
+ *   telemetry_query --where "speed > 25 && steering > 0.3" *.rec
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../recording_format.h"
+
+#ifdef _WIN32
+#  define file_seek _fseeki64
+#else
+#  define file_seek fseeko
+#endif
+
+enum compare_t { compare_less, compare_less_equal, compare_greater, compare_greater_equal };
+
+struct condition_t
+{
+	int channel;
+	compare_t compare;
+	float value;
+};
+
+enum output_t { output_intervals, output_samples, output_aggregate };
+
+struct query_t
+{
+	scs_u64_t from;
+	scs_u64_t to;
+	std::vector<condition_t> conditions;
+	std::vector<int> selected;
+	output_t output;
+};
+
+struct aggregate_t
+{
+	scs_u64_t count;
+	double sum[recordingMaxChannels];
+	float minimum[recordingMaxChannels];
+	float maximum[recordingMaxChannels];
+};
+
+struct file_result_t
+{
+	std::string text;
+	aggregate_t aggregate;
+	scs_u64_t chunks_read;
+	scs_u64_t chunks_skipped;
+	scs_u64_t samples_scanned;
+	bool failed;
+};
+
+static int find_channel(const char* const name)
+{
+	for (int c = 0; c < recording_channel_count; c++)
+	{
+		if (strcmp(recordingChannelNames[c], name) == 0) {
+			return c;
+		}
+	}
+	return -1;
+}
+
+static std::string trim(const std::string& text)
+{
+	const size_t begin = text.find_first_not_of(" \t");
+	if (begin == std::string::npos) {
+		return std::string();
+	}
+	const size_t end = text.find_last_not_of(" \t");
+	return text.substr(begin, end - begin + 1);
+}
+
+// Parses "a > 1 && b <= 2" style conjunctions.
+static bool parse_conditions(const std::string& text, std::vector<condition_t>& conditions)
+{
+	size_t start = 0;
+	for (;;)
+	{
+		const size_t separator = text.find("&&", start);
+		const std::string term = trim(text.substr(start, separator == std::string::npos ? std::string::npos : separator - start));
+
+		const size_t op = term.find_first_of("<>");
+		if (op == std::string::npos || op == 0) {
+			fprintf(stderr, "Invalid condition '%s'\n", term.c_str());
+			return false;
+		}
+
+		condition_t condition;
+		const bool equal = (op + 1 < term.size() && term[op + 1] == '=');
+		if (term[op] == '<') {
+			condition.compare = equal ? compare_less_equal : compare_less;
+		}
+		else {
+			condition.compare = equal ? compare_greater_equal : compare_greater;
+		}
+
+		const std::string name = trim(term.substr(0, op));
+		condition.channel = find_channel(name.c_str());
+		if (condition.channel < 0) {
+			fprintf(stderr, "Unknown channel '%s'\n", name.c_str());
+			return false;
+		}
+
+		const std::string value = trim(term.substr(op + (equal ? 2 : 1)));
+		char* end = NULL;
+		condition.value = strtof(value.c_str(), &end);
+		if (value.empty() || *end != '\0') {
+			fprintf(stderr, "Invalid value '%s'\n", value.c_str());
+			return false;
+		}
+		conditions.push_back(condition);
+
+		if (separator == std::string::npos) {
+			return true;
+		}
+		start = separator + 2;
+	}
+}
+
+static bool parse_selection(const std::string& text, std::vector<int>& selected)
+{
+	size_t start = 0;
+	for (;;)
+	{
+		const size_t separator = text.find(',', start);
+		const std::string name = trim(text.substr(start, separator == std::string::npos ? std::string::npos : separator - start));
+		const int channel = find_channel(name.c_str());
+		if (channel < 0) {
+			fprintf(stderr, "Unknown channel '%s'\n", name.c_str());
+			return false;
+		}
+		selected.push_back(channel);
+
+		if (separator == std::string::npos) {
+			return true;
+		}
+		start = separator + 1;
+	}
+}
+
+static bool matches(const query_t& query, const float* const values)
+{
+	for (size_t i = 0; i < query.conditions.size(); i++)
+	{
+		const condition_t& condition = query.conditions[i];
+		const float value = values[condition.channel];
+		switch (condition.compare)
+		{
+			case compare_less: if (!(value < condition.value)) return false; break;
+			case compare_less_equal: if (!(value <= condition.value)) return false; break;
+			case compare_greater: if (!(value > condition.value)) return false; break;
+			case compare_greater_equal: if (!(value >= condition.value)) return false; break;
+		}
+	}
+	return true;
+}
+
+// Whether any sample inside the chunk can match, judging by its footer.
+static bool chunk_may_match(const query_t& query, const recording_chunk_footer_t& footer)
+{
+	for (size_t i = 0; i < query.conditions.size(); i++)
+	{
+		const condition_t& condition = query.conditions[i];
+		const float minimum = footer.minimum[condition.channel];
+		const float maximum = footer.maximum[condition.channel];
+		switch (condition.compare)
+		{
+			case compare_less: if (!(minimum < condition.value)) return false; break;
+			case compare_less_equal: if (!(minimum <= condition.value)) return false; break;
+			case compare_greater: if (!(maximum > condition.value)) return false; break;
+			case compare_greater_equal: if (!(maximum >= condition.value)) return false; break;
+		}
+	}
+	return true;
+}
+
+static void append_format(std::string& text, const char* const format, ...)
+{
+	char buffer[512];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	text += buffer;
+}
+
+static void scan_file(const char* const path, const query_t& query, file_result_t& result)
+{
+	FILE* const file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "%s: unable to open\n", path);
+		result.failed = true;
+		return;
+	}
+
+	recording_file_header_t header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, recordingMagic, sizeof(header.magic)) != 0) {
+		fprintf(stderr, "%s: not a telemetry recording\n", path);
+		fclose(file);
+		result.failed = true;
+		return;
+	}
+	if (header.version != recordingVersion || header.channel_count != recording_channel_count) {
+		fprintf(stderr, "%s: unsupported recording version %u\n", path, header.version);
+		fclose(file);
+		result.failed = true;
+		return;
+	}
+
+	std::vector<recording_sample_t> samples(header.chunk_samples);
+	bool inside = false;
+	scs_u64_t interval_start = 0;
+	scs_u64_t interval_end = 0;
+
+	scs_u64_t offset = sizeof(header);
+	recording_chunk_header_t chunk;
+	recording_chunk_footer_t footer;
+	while (file_seek(file, offset, SEEK_SET) == 0 && fread(&chunk, sizeof(chunk), 1, file) == 1)
+	{
+		// The chunks must move forward and the footer lie inside the chunk,
+		// or a corrupted file would be scanned in a loop.
+		const scs_u64_t samples_offset = offset + sizeof(chunk);
+		if (chunk.magic != recordingChunkMagic || chunk.sample_count > header.chunk_samples || chunk.next_offset <= offset ||
+			chunk.footer_offset < samples_offset || chunk.footer_offset + sizeof(footer) > chunk.next_offset) {
+			fprintf(stderr, "%s: corrupted chunk at offset %llu\n", path, static_cast<unsigned long long>(offset));
+			break;
+		}
+		offset = chunk.next_offset;
+
+		if (chunk.last_time < query.from || chunk.first_time > query.to) {
+			result.chunks_skipped++;
+			continue;
+		}
+		if (file_seek(file, chunk.footer_offset, SEEK_SET) != 0 || fread(&footer, sizeof(footer), 1, file) != 1 || footer.magic != recordingFooterMagic || footer.index_count == 0 || footer.index_count > recordingIndexEntries) {
+			fprintf(stderr, "%s: missing chunk footer\n", path);
+			break;
+		}
+		if (!chunk_may_match(query, footer)) {
+			if (inside) {
+				append_format(result.text, "%s,%.3f,%.3f,%.3f\n", path, interval_start / 1e6, interval_end / 1e6, (interval_end - interval_start) / 1e6);
+				inside = false;
+			}
+			result.chunks_skipped++;
+			continue;
+		}
+
+		// Seek to the last index entry at or before the window start.
+		scs_u64_t first_offset = footer.index[0].offset;
+		for (scs_u32_t i = 1; i < footer.index_count && footer.index[i].time <= query.from; i++)
+		{
+			first_offset = footer.index[i].offset;
+		}
+		// The offsets come from the file, the samples must lie between the
+		// chunk header and the footer and fit the buffer.
+		if (first_offset < samples_offset || first_offset > chunk.footer_offset || (chunk.footer_offset - first_offset) / sizeof(recording_sample_t) > chunk.sample_count) {
+			fprintf(stderr, "%s: corrupted chunk index at offset %llu\n", path, static_cast<unsigned long long>(samples_offset - sizeof(chunk)));
+			break;
+		}
+		const size_t count = static_cast<size_t>((chunk.footer_offset - first_offset) / sizeof(recording_sample_t));
+		if (file_seek(file, first_offset, SEEK_SET) != 0 || fread(samples.data(), sizeof(recording_sample_t), count, file) != count) {
+			fprintf(stderr, "%s: truncated chunk\n", path);
+			break;
+		}
+		result.chunks_read++;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const recording_sample_t& sample = samples[i];
+			if (sample.time < query.from) {
+				continue;
+			}
+			if (sample.time > query.to) {
+				break;
+			}
+			result.samples_scanned++;
+
+			if (!matches(query, sample.values)) {
+				if (inside) {
+					append_format(result.text, "%s,%.3f,%.3f,%.3f\n", path, interval_start / 1e6, interval_end / 1e6, (interval_end - interval_start) / 1e6);
+					inside = false;
+				}
+				continue;
+			}
+
+			switch (query.output)
+			{
+				case output_intervals:
+					if (!inside) {
+						interval_start = sample.time;
+						inside = true;
+					}
+					interval_end = sample.time;
+					break;
+
+				case output_samples:
+					append_format(result.text, "%s,%.6f", path, sample.time / 1e6);
+					for (size_t s = 0; s < query.selected.size(); s++)
+					{
+						append_format(result.text, ",%g", sample.values[query.selected[s]]);
+					}
+					result.text += '\n';
+					break;
+
+				case output_aggregate:
+					for (size_t s = 0; s < query.selected.size(); s++)
+					{
+						const int channel = query.selected[s];
+						const float value = sample.values[channel];
+						if (result.aggregate.count == 0 || value < result.aggregate.minimum[channel]) {
+							result.aggregate.minimum[channel] = value;
+						}
+						if (result.aggregate.count == 0 || value > result.aggregate.maximum[channel]) {
+							result.aggregate.maximum[channel] = value;
+						}
+						result.aggregate.sum[channel] += value;
+					}
+					result.aggregate.count++;
+					break;
+			}
+		}
+	}
+	if (inside) {
+		append_format(result.text, "%s,%.3f,%.3f,%.3f\n", path, interval_start / 1e6, interval_end / 1e6, (interval_end - interval_start) / 1e6);
+	}
+
+	fclose(file);
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: telemetry_query [options] <recording>...\n"
+		"  --from <seconds>      start of the time window (simulation time)\n"
+		"  --to <seconds>        end of the time window\n"
+		"  --where <filter>      conjunction of channel comparisons, e.g. \"speed > 25 && steering > 0.3\"\n"
+		"  --select <channels>   print matching samples as CSV with these channels\n"
+		"  --aggregate <channels> print count/min/max/mean of these channels over matching samples\n"
+		"  -j <threads>          number of worker threads (default: all cores)\n"
+		"Without --select or --aggregate the matching time intervals are printed.\n"
+		"Channels:");
+	for (int c = 0; c < recording_channel_count; c++)
+	{
+		fprintf(stderr, " %s", recordingChannelNames[c]);
+	}
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+	query_t query;
+	query.from = 0;
+	query.to = ~static_cast<scs_u64_t>(0);
+	query.output = output_intervals;
+
+	unsigned threads = std::thread::hardware_concurrency();
+	std::vector<const char*> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		const bool has_value = (i + 1 < argc);
+		if (argument == "--from" && has_value) {
+			query.from = static_cast<scs_u64_t>(atof(argv[++i]) * 1e6);
+		}
+		else if (argument == "--to" && has_value) {
+			query.to = static_cast<scs_u64_t>(atof(argv[++i]) * 1e6);
+		}
+		else if (argument == "--where" && has_value) {
+			if (!parse_conditions(argv[++i], query.conditions)) {
+				return 1;
+			}
+		}
+		else if ((argument == "--select" || argument == "--aggregate") && has_value) {
+			query.output = (argument == "--select") ? output_samples : output_aggregate;
+			if (!parse_selection(argv[++i], query.selected)) {
+				return 1;
+			}
+		}
+		else if (argument == "-j" && has_value) {
+			threads = static_cast<unsigned>(atoi(argv[++i]));
+		}
+		else if (argument[0] == '-') {
+			usage();
+			return 1;
+		}
+		else {
+			files.push_back(argv[i]);
+		}
+	}
+	if (files.empty()) {
+		usage();
+		return 1;
+	}
+	if (threads == 0) {
+		threads = 1;
+	}
+	if (threads > files.size()) {
+		threads = static_cast<unsigned>(files.size());
+	}
+
+	const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+	// Files are handed out one at a time, results are printed in argument order.
+	std::vector<file_result_t> results(files.size());
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		memset(&results[i].aggregate, 0, sizeof(results[i].aggregate));
+		results[i].chunks_read = 0;
+		results[i].chunks_skipped = 0;
+		results[i].samples_scanned = 0;
+		results[i].failed = false;
+	}
+
+	std::atomic<size_t> next_file(0);
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; t++)
+	{
+		workers.push_back(std::thread([&] {
+			for (size_t i = next_file++; i < files.size(); i = next_file++)
+			{
+				scan_file(files[i], query, results[i]);
+			}
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+
+	aggregate_t total;
+	memset(&total, 0, sizeof(total));
+	scs_u64_t chunks_read = 0;
+	scs_u64_t chunks_skipped = 0;
+	scs_u64_t samples_scanned = 0;
+	bool failed = false;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const file_result_t& result = results[i];
+		fputs(result.text.c_str(), stdout);
+		chunks_read += result.chunks_read;
+		chunks_skipped += result.chunks_skipped;
+		samples_scanned += result.samples_scanned;
+		failed = failed || result.failed;
+
+		if (result.aggregate.count == 0) {
+			continue;
+		}
+		for (size_t s = 0; s < query.selected.size(); s++)
+		{
+			const int channel = query.selected[s];
+			if (total.count == 0 || result.aggregate.minimum[channel] < total.minimum[channel]) {
+				total.minimum[channel] = result.aggregate.minimum[channel];
+			}
+			if (total.count == 0 || result.aggregate.maximum[channel] > total.maximum[channel]) {
+				total.maximum[channel] = result.aggregate.maximum[channel];
+			}
+			total.sum[channel] += result.aggregate.sum[channel];
+		}
+		total.count += result.aggregate.count;
+	}
+
+	if (query.output == output_aggregate) {
+		printf("channel,count,min,max,mean\n");
+		for (size_t s = 0; s < query.selected.size(); s++)
+		{
+			const int channel = query.selected[s];
+			printf("%s,%llu,%g,%g,%g\n", recordingChannelNames[channel], static_cast<unsigned long long>(total.count),
+				total.minimum[channel], total.maximum[channel], total.count ? total.sum[channel] / total.count : 0.0);
+		}
+	}
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	fprintf(stderr, "%zu files, %llu chunks read, %llu chunks skipped, %llu samples scanned in %.3f s\n",
+		files.size(), static_cast<unsigned long long>(chunks_read), static_cast<unsigned long long>(chunks_skipped),
+		static_cast<unsigned long long>(samples_scanned), elapsed);
+
+	return failed ? 1 : 0;
+}
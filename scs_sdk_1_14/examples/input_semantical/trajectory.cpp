@@ -0,0 +1,142 @@
+#include <string.h>
+
+#include "trajectory.h"
+
+// Number of attempts to get a consistent copy of the active buffer before
+// falling back to the previous one.
+const int trajectoryReadAttempts = 3;
+
+// The last consistent copy of the active buffer and space for the next one.
+static trajectory_buffer_t copies[2];
+static trajectory_buffer_t* cached = &copies[0];
+static bool cachedValid = false;
+
+static void copy_active(trajectory_t& trajectory)
+{
+	trajectory_buffer_t* const scratch = (cached == &copies[0]) ? &copies[1] : &copies[0];
+
+	for (int attempt = 0; attempt < trajectoryReadAttempts; attempt++)
+	{
+		const trajectory_buffer_t& buffer = trajectory.buffers[trajectory.active.load(std::memory_order_acquire) & 1];
+
+		const scs_u32_t before = buffer.sequence.load(std::memory_order_acquire);
+		if (before & 1) {
+			continue;
+		}
+		scs_u32_t count = buffer.knot_count;
+		if (count > static_cast<scs_u32_t>(trajectoryKnotCount)) {
+			count = trajectoryKnotCount;
+		}
+		memcpy(scratch->knots, buffer.knots, count * sizeof(trajectory_knot_t));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (buffer.sequence.load(std::memory_order_relaxed) == before) {
+			scratch->knot_count = count;
+			cached = scratch;
+			cachedValid = true;
+			return;
+		}
+	}
+
+	// Keep sampling the previous trajectory.
+	trajectory.torn_reads.fetch_add(1, std::memory_order_relaxed);
+}
+
+static float knot_value(const trajectory_knot_t& knot, const int component)
+{
+	return component == 0 ? knot.steering : (component == 1 ? knot.throttle : knot.brake);
+}
+
+// Finite difference tangent at knot i in value per microsecond.
+static float knot_tangent(const trajectory_knot_t* const knots, const int count, const int i, const int component)
+{
+	const int previous = i > 0 ? i - 1 : i;
+	const int next = i < count - 1 ? i + 1 : i;
+	const double span = static_cast<double>(knots[next].time - knots[previous].time);
+	if (span <= 0.0) {
+		return 0.0f;
+	}
+	return static_cast<float>((knot_value(knots[next], component) - knot_value(knots[previous], component)) / span);
+}
+
+static float clamp(const float value, const float minimum, const float maximum)
+{
+	return value < minimum ? minimum : (value > maximum ? maximum : value);
+}
+
+bool trajectory_sample(trajectory_t& trajectory, const scs_u64_t time, float& steering, float& throttle, float& brake)
+{
+	if (!trajectory.enabled.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	copy_active(trajectory);
+	if (!cachedValid || cached->knot_count == 0) {
+		return false;
+	}
+
+	const trajectory_knot_t* const knots = cached->knots;
+	const int count = static_cast<int>(cached->knot_count);
+	float result[3];
+
+	if (count == 1 || time <= knots[0].time) {
+		for (int c = 0; c < 3; c++)
+		{
+			result[c] = knot_value(knots[0], c);
+		}
+	}
+	else if (time >= knots[count - 1].time) {
+		// Linear extrapolation from the last segment, held past the horizon.
+		const scs_u32_t horizon = trajectory.max_extrapolation ? trajectory.max_extrapolation : defaultTrajectoryExtrapolation;
+		scs_u64_t ahead = time - knots[count - 1].time;
+		if (ahead > horizon) {
+			ahead = horizon;
+		}
+		const trajectory_knot_t& a = knots[count - 2];
+		const trajectory_knot_t& b = knots[count - 1];
+		const double span = static_cast<double>(b.time - a.time);
+		for (int c = 0; c < 3; c++)
+		{
+			const double slope = span > 0.0 ? (knot_value(b, c) - knot_value(a, c)) / span : 0.0;
+			result[c] = static_cast<float>(knot_value(b, c) + slope * ahead);
+		}
+		trajectory.extrapolated.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		int i = 0;
+		while (i < count - 2 && knots[i + 1].time <= time)
+		{
+			i++;
+		}
+		const trajectory_knot_t& a = knots[i];
+		const trajectory_knot_t& b = knots[i + 1];
+		const double span = static_cast<double>(b.time - a.time);
+		const float t = span > 0.0 ? static_cast<float>((time - a.time) / span) : 1.0f;
+
+		for (int c = 0; c < 3; c++)
+		{
+			const float p0 = knot_value(a, c);
+			const float p1 = knot_value(b, c);
+			if (trajectory.interpolation == trajectory_interpolation_hermite) {
+				const float m0 = knot_tangent(knots, count, i, c) * static_cast<float>(span);
+				const float m1 = knot_tangent(knots, count, i + 1, c) * static_cast<float>(span);
+				const float t2 = t * t;
+				const float t3 = t2 * t;
+				result[c] = (2 * t3 - 3 * t2 + 1) * p0 + (t3 - 2 * t2 + t) * m0 + (-2 * t3 + 3 * t2) * p1 + (t3 - t2) * m1;
+			}
+			else {
+				result[c] = p0 + (p1 - p0) * t;
+			}
+		}
+	}
+
+	steering = clamp(result[0], -1.0f, 1.0f);
+	throttle = clamp(result[1], 0.0f, 1.0f);
+	brake = clamp(result[2], 0.0f, 1.0f);
+	trajectory.samples.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void trajectory_reset(void)
+{
+	cachedValid = false;
+}
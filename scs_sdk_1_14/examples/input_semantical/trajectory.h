@@ -0,0 +1,17 @@
+#ifndef INPUT_SEMANTICAL_TRAJECTORY_H
+#define INPUT_SEMANTICAL_TRAJECTORY_H
+
+#include "control_layout.h"
+
+/**
+ * @brief Samples the producer trajectory at the given time.
+ *
+ * Returns false when no trajectory is enabled. When the active buffer is
+ * being rewritten during the read, the last consistent copy is used.
+ */
+bool trajectory_sample(trajectory_t& trajectory, const scs_u64_t time, float& steering, float& throttle, float& brake);
+
+// Forgets the cached copy, e.g. when the control block is recreated.
+void trajectory_reset(void);
+
+#endif // INPUT_SEMANTICAL_TRAJECTORY_H